@@ -0,0 +1,395 @@
+// Offline benchmarks for the effect and conversion hot paths: synthetic
+// frames, fixed seeds, no camera or v4l2loopback device needed.
+
+#include "matrix_effect.h"
+#include "static_effect.h"
+#include "blend.h"
+#include "pixel_convert.h"
+#include "frame_scaler.h"
+#include "time_utils.h"
+#include "fast_rng.h"
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <getopt.h>
+#include <unistd.h>
+
+struct BenchSize {
+    const char* name;
+    int width;
+    int height;
+};
+
+static const BenchSize ALL_SIZES[] = {
+    {"480p", 640, 480},
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"4k", 3840, 2160},
+};
+
+// The cached static mode keeps 150 grayscale frames in memory; at 4K that's
+// over a gigabyte, so it's only benchmarked up to this many pixels
+static constexpr int MAX_CACHE_PIXELS = 1920 * 1080;
+
+struct BenchOptions {
+    std::vector<BenchSize> sizes;
+    std::string filter;             // Substring of the benchmark name
+    uint64_t minTimeMs = 500;       // Per benchmark
+    uint32_t seed = 1;
+    int renderThreads = 1;          // Serial by default, for stable numbers
+    bool json = false;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string size;
+    int iterations = 0;
+    double nsPerFrame = 0.0;
+    double mbPerSec = 0.0;          // Output bytes per second
+};
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Time fn() until minTimeMs has passed (at least a few runs), after warm-up
+static BenchResult measure(const std::string& name, const BenchSize& size, size_t bytesPerFrame,
+                           const BenchOptions& options, const std::function<void()>& fn) {
+    for (int i = 0; i < 3; ++i) fn();
+
+    BenchResult result;
+    result.name = name;
+    result.size = size.name;
+    const uint64_t minTimeNs = options.minTimeMs * 1000000;
+    uint64_t start = nowNs();
+    uint64_t elapsed = 0;
+    while (result.iterations < 5 || elapsed < minTimeNs) {
+        fn();
+        result.iterations++;
+        elapsed = nowNs() - start;
+    }
+    result.nsPerFrame = static_cast<double>(elapsed) / result.iterations;
+    result.mbPerSec = bytesPerFrame / result.nsPerFrame * 1e9 / (1024.0 * 1024.0);
+    return result;
+}
+
+// Deterministic camera-like frame: seeded noise, blurred into blobs
+static cv::Mat syntheticFrame(const BenchSize& size, uint32_t seed) {
+    cv::Mat frame(size.height, size.width, CV_8UC3);
+    FastRng rng(seed);
+    std::vector<uint32_t> row(static_cast<size_t>(size.width) * 3);
+    for (int y = 0; y < size.height; ++y) {
+        rng.fill(row.data(), row.size());
+        uint8_t* dst = frame.ptr(y);
+        for (size_t i = 0; i < row.size(); ++i) {
+            dst[i] = static_cast<uint8_t>(row[i] >> 24);
+        }
+    }
+    cv::GaussianBlur(frame, frame, cv::Size(9, 9), 0);
+    return frame;
+}
+
+static void benchMatrix(const BenchSize& size, const BenchOptions& options, std::vector<BenchResult>& results,
+                        const std::function<bool(const std::string&)>& selected) {
+    MatrixEffect matrix;
+    matrix.setSeed(options.seed);
+    matrix.setRenderThreads(options.renderThreads);
+    matrix.initialize(size.width, size.height);
+    cv::Mat background = syntheticFrame(size, options.seed);
+    cv::Mat out;
+
+    struct Case {
+        const char* name;
+        PixelFormat format;
+        BlendMode mode;
+    };
+    const Case cases[] = {
+        {"matrix-yuyv", PixelFormat::YUYV, BlendMode::REPLACE},
+        {"matrix-bgr", PixelFormat::BGR24, BlendMode::REPLACE},
+        {"matrix-overlay-yuyv", PixelFormat::YUYV, BlendMode::OVERLAY},
+    };
+
+    for (const Case& c : cases) {
+        if (!selected(c.name)) continue;
+
+        // Every frame is an animation tick, the worst case for redraws
+        matrix.reset();
+        uint64_t t = 1;
+        matrix.update(t);
+        size_t bytes = static_cast<size_t>(size.width) * size.height * (c.format == PixelFormat::YUYV ? 2 : 3);
+        results.push_back(measure(c.name, size, bytes, options, [&] {
+            t += 50;
+            matrix.update(t);
+            matrix.renderInto(out, c.format, c.mode, background);
+        }));
+    }
+}
+
+static void benchStatic(const BenchSize& size, const BenchOptions& options, std::vector<BenchResult>& results,
+                        const std::function<bool(const std::string&)>& selected) {
+    cv::Mat out;
+
+    if (selected("static-procedural-yuyv")) {
+        StaticEffect effect;
+        effect.setSeed(options.seed);
+        effect.setMode(StaticMode::PROCEDURAL);
+        effect.initialize(size.width, size.height);
+        effect.resetForEffect();
+        uint64_t t = 1;
+        results.push_back(measure("static-procedural-yuyv", size, static_cast<size_t>(size.width) * size.height * 2,
+                                  options, [&] {
+            effect.update(t += 33);
+            effect.renderInto(out, PixelFormat::YUYV);
+        }));
+    }
+
+    bool wantBuild = selected("static-cache-build");
+    bool wantCached = selected("static-cached-yuyv");
+    if ((!wantBuild && !wantCached) || size.width * size.height > MAX_CACHE_PIXELS) {
+        return;
+    }
+
+    // Build into a private directory so an existing cache isn't just mapped
+    std::string dir = (std::filesystem::temp_directory_path() /
+                       ("matrix-filter-bench-" + std::to_string(getpid()))).string();
+    StaticEffect effect;
+    effect.setSeed(options.seed);
+    effect.setMode(StaticMode::CACHED);
+    effect.setCacheDir(dir);
+
+    uint64_t start = nowNs();
+    effect.initialize(size.width, size.height);
+    if (!effect.isFontLoaded()) {
+        std::cerr << "No CJK font found, skipping cached static benchmarks\n";
+        std::filesystem::remove_all(dir);
+        return;
+    }
+    while (!effect.isCacheComplete()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (wantBuild) {
+        // One cold build, reported per cached frame (all sizes, pool threads)
+        BenchResult result;
+        result.name = "static-cache-build";
+        result.size = size.name;
+        result.iterations = StaticEffect::getCacheFrameCount();
+        result.nsPerFrame = static_cast<double>(nowNs() - start) / result.iterations;
+        result.mbPerSec = static_cast<double>(size.width) * size.height / result.nsPerFrame * 1e9 / (1024.0 * 1024.0);
+        results.push_back(result);
+    }
+
+    if (wantCached) {
+        // Reload from the saved file, the steady state after the first run
+        effect.initialize(size.width, size.height);
+        effect.resetForEffect();
+        uint64_t t = 1;
+        results.push_back(measure("static-cached-yuyv", size, static_cast<size_t>(size.width) * size.height * 2,
+                                  options, [&] {
+            effect.update(t += 33);
+            effect.renderInto(out, PixelFormat::YUYV);
+        }));
+    }
+    std::filesystem::remove_all(dir);
+}
+
+static void benchConvert(const BenchSize& size, const BenchOptions& options, std::vector<BenchResult>& results,
+                         const std::function<bool(const std::string&)>& selected) {
+    cv::Mat bgr = syntheticFrame(size, options.seed);
+    cv::Mat layer = syntheticFrame(size, options.seed + 1);
+    cv::Mat yuyv(size.height, size.width, CV_8UC2);
+    const size_t yuyvBytes = static_cast<size_t>(size.width) * size.height * 2;
+
+    // What VirtualOutput::writeFrame does for every BGR frame
+    if (selected("bgr-to-yuyv")) {
+        results.push_back(measure("bgr-to-yuyv", size, yuyvBytes, options, [&] {
+            cv::cvtColor(bgr, yuyv, cv::COLOR_BGR2YUV_YUYV);
+        }));
+    }
+
+    if (selected("bgr-to-yuyv-columns")) {
+        results.push_back(measure("bgr-to-yuyv-columns", size, yuyvBytes, options, [&] {
+            bgrToYUYVColumns(bgr, yuyv, 0, size.width);
+        }));
+    }
+
+    // A camera frame of this size written to a 720p consumer: the old
+    // resize-then-convert path against the fused scaler
+    const BenchSize consumer = {"720p", 1280, 720};
+    cv::Mat consumerYUYV(consumer.height, consumer.width, CV_8UC2);
+    const size_t consumerBytes = static_cast<size_t>(consumer.width) * consumer.height * 2;
+    if (selected("resize-then-yuyv")) {
+        cv::Mat resized;
+        results.push_back(measure("resize-then-yuyv", size, consumerBytes, options, [&] {
+            cv::resize(bgr, resized, cv::Size(consumer.width, consumer.height));
+            cv::cvtColor(resized, consumerYUYV, cv::COLOR_BGR2YUV_YUYV);
+        }));
+    }
+    for (ScaleFilter filter : {ScaleFilter::NEAREST, ScaleFilter::BILINEAR, ScaleFilter::AREA}) {
+        std::string name = std::string("scale-yuyv-") + scaleFilterName(filter);
+        if (!selected(name)) continue;
+        FrameScaler scaler;
+        scaler.setFilter(filter);
+        results.push_back(measure(name, size, consumerBytes, options, [&] {
+            scaler.toYUYV(bgr, consumerYUYV);
+        }));
+    }
+
+    if (selected("blend-overlay")) {
+        cv::Mat dst = bgr.clone();
+        results.push_back(measure("blend-overlay", size, static_cast<size_t>(size.width) * size.height * 3,
+                                  options, [&] {
+            for (int y = 0; y < size.height; ++y) {
+                blendOverlayBGR(dst.ptr(y), layer.ptr(y), size.width, 230);
+            }
+        }));
+    }
+}
+
+static void printUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n\n"
+              << "Options:\n"
+              << "  --res <list>         Sizes to run: 480p,720p,1080p,4k (default: all)\n"
+              << "  --filter <text>      Only benchmarks whose name contains text\n"
+              << "  --min-time <time>    Minimum run time per benchmark (default: 500ms)\n"
+              << "  --seed <n>           Effect seed (default: 1)\n"
+              << "  --render-threads <n> Matrix render threads, 0=one per core (default: 1)\n"
+              << "  --json               Print results as JSON\n"
+              << "  -h, --help           Show this help\n\n"
+              << "Benchmarks: matrix-yuyv, matrix-bgr, matrix-overlay-yuyv, static-procedural-yuyv,\n"
+              << "  static-cache-build, static-cached-yuyv (up to 1080p), bgr-to-yuyv,\n"
+              << "  bgr-to-yuyv-columns, resize-then-yuyv, scale-yuyv-{nearest,bilinear,area}\n"
+              << "  (scaling to 720p), blend-overlay\n";
+}
+
+static BenchOptions parseArgs(int argc, char* argv[]) {
+    BenchOptions options;
+    options.sizes.assign(std::begin(ALL_SIZES), std::end(ALL_SIZES));
+
+    static struct option longOptions[] = {
+        {"res",            required_argument, nullptr, 'r'},
+        {"filter",         required_argument, nullptr, 'f'},
+        {"min-time",       required_argument, nullptr, 'm'},
+        {"seed",           required_argument, nullptr, 'R'},
+        {"render-threads", required_argument, nullptr, 'T'},
+        {"json",           no_argument,       nullptr, 'j'},
+        {"help",           no_argument,       nullptr, 'h'},
+        {nullptr,          0,                 nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:f:h", longOptions, nullptr)) != -1) {
+        try {
+            switch (opt) {
+                case 'r': {
+                    options.sizes.clear();
+                    std::stringstream list(optarg);
+                    std::string name;
+                    while (std::getline(list, name, ',')) {
+                        bool found = false;
+                        for (const BenchSize& size : ALL_SIZES) {
+                            if (name == size.name) {
+                                options.sizes.push_back(size);
+                                found = true;
+                            }
+                        }
+                        if (!found) {
+                            std::cerr << "Unknown size: " << name << " (use 480p, 720p, 1080p or 4k)\n";
+                            exit(1);
+                        }
+                    }
+                    break;
+                }
+                case 'f':
+                    options.filter = optarg;
+                    break;
+                case 'm':
+                    options.minTimeMs = parseTime(optarg);
+                    break;
+                case 'R':
+                    options.seed = static_cast<uint32_t>(std::stoul(optarg));
+                    break;
+                case 'T':
+                    options.renderThreads = std::stoi(optarg);
+                    break;
+                case 'j':
+                    options.json = true;
+                    break;
+                case 'h':
+                    printUsage(argv[0]);
+                    exit(0);
+                default:
+                    printUsage(argv[0]);
+                    exit(1);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error parsing argument: " << e.what() << "\n";
+            exit(1);
+        }
+    }
+    return options;
+}
+
+static void printTable(const std::vector<BenchResult>& results) {
+    std::cout << std::left << std::setw(24) << "benchmark" << std::setw(8) << "size"
+              << std::right << std::setw(8) << "iters" << std::setw(14) << "ns/frame"
+              << std::setw(12) << "MB/s" << "\n";
+    for (const BenchResult& r : results) {
+        std::cout << std::left << std::setw(24) << r.name << std::setw(8) << r.size
+                  << std::right << std::setw(8) << r.iterations
+                  << std::setw(14) << std::fixed << std::setprecision(0) << r.nsPerFrame
+                  << std::setw(12) << std::setprecision(1) << r.mbPerSec << "\n";
+    }
+}
+
+static void printJson(const std::vector<BenchResult>& results, const BenchOptions& options) {
+    std::cout << "{\n  \"seed\": " << options.seed
+              << ",\n  \"render_threads\": " << options.renderThreads
+              << ",\n  \"blend_kernel\": \"" << blendKernelName() << "\""
+              << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        std::cout << (i ? "," : "") << "\n    {\"name\": \"" << r.name << "\", \"size\": \"" << r.size
+                  << "\", \"iterations\": " << r.iterations
+                  << std::fixed << std::setprecision(1)
+                  << ", \"ns_per_frame\": " << r.nsPerFrame
+                  << ", \"mb_per_s\": " << r.mbPerSec << "}";
+    }
+    std::cout << "\n  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = parseArgs(argc, argv);
+    auto selected = [&](const std::string& name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    };
+
+    // Effects print font and cache messages; keep them off a JSON stdout
+    std::streambuf* coutBuf = std::cout.rdbuf();
+    if (options.json) {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
+    std::vector<BenchResult> results;
+    for (const BenchSize& size : options.sizes) {
+        benchMatrix(size, options, results, selected);
+        benchStatic(size, options, results, selected);
+        benchConvert(size, options, results, selected);
+    }
+
+    std::cout.rdbuf(coutBuf);
+    if (options.json) {
+        printJson(results, options);
+    } else {
+        printTable(results);
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "alloc_counter.h"
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocationCount{0};
+
+// Counts, then defers to whatever allocator was the default before
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+    explicit CountingMatAllocator(cv::MatAllocator* base) : base_(base) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        if (!data) {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return base_->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return base_->allocate(data, accessFlags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData* data) const override {
+        base_->deallocate(data);
+    }
+
+private:
+    cv::MatAllocator* base_;
+};
+
+void installAllocCounter() {
+    // Never destroyed: Mats released during static destruction still use it
+    static CountingMatAllocator* allocator = new CountingMatAllocator(cv::Mat::getDefaultAllocator());
+    cv::Mat::setDefaultAllocator(allocator);
+}
+
+uint64_t getAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+// Replacements for the global allocation functions; the nothrow and array
+// forms of the standard library forward to these
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Process-wide allocation counter, to check that steady-state frames stay off
+// the heap. Counts every global operator new, and every cv::Mat buffer once
+// installAllocCounter() has routed OpenCV's default allocator through it.
+// Memory malloc()ed directly by C libraries (libjpeg, FreeType) isn't seen.
+void installAllocCounter();
+uint64_t getAllocationCount();
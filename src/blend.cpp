@@ -0,0 +1,192 @@
+#include "blend.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BLEND_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BLEND_NEON 1
+#endif
+
+static inline uint8_t mix(int src, int dst, int a) {
+    return static_cast<uint8_t>((src * a + dst * (256 - a) + 128) >> 8);
+}
+
+// ---------------------------------------------------------------------------
+// Scalar kernels (also used for row tails by the SIMD kernels)
+// ---------------------------------------------------------------------------
+
+static void overlayScalar(uint8_t* dst, const uint8_t* src, int pixels, int opacity) {
+    for (int x = 0; x < pixels; ++x, dst += 3, src += 3) {
+        // Branch-free: weight is zero where the source pixel is black
+        int a = (src[0] | src[1] | src[2]) ? opacity : 0;
+        dst[0] = mix(src[0], dst[0], a);
+        dst[1] = mix(src[1], dst[1], a);
+        dst[2] = mix(src[2], dst[2], a);
+    }
+}
+
+#if BLEND_X86
+
+// SSE/AVX2 kernels work on 5 BGR pixels (15 bytes) per 128-bit lane. The 16th
+// byte always gets weight 0, so it is written back unchanged; callers only take
+// the vector path while at least 6 pixels remain so that byte is in bounds.
+
+__attribute__((target("sse4.1")))
+static inline __m128i mix16SSE(__m128i s, __m128i d, __m128i a) {
+    const __m128i full = _mm_set1_epi16(256);
+    const __m128i round = _mm_set1_epi16(128);
+    __m128i r = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(full, a)));
+    return _mm_srli_epi16(_mm_add_epi16(r, round), 8);
+}
+
+// Blend 15 bytes with a per-byte mask m (0x00 / 0xFF) selecting weight a
+__attribute__((target("sse4.1")))
+static inline __m128i blendMaskedSSE(__m128i s, __m128i d, __m128i m, __m128i a) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i alo = _mm_and_si128(_mm_unpacklo_epi8(m, m), a);
+    __m128i ahi = _mm_and_si128(_mm_unpackhi_epi8(m, m), a);
+    __m128i lo = mix16SSE(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), alo);
+    __m128i hi = mix16SSE(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), ahi);
+    return _mm_packus_epi16(lo, hi);
+}
+
+// Spread a per-pixel flag (any channel non-zero) to all three channel bytes
+__attribute__((target("sse4.1")))
+static inline __m128i pixelMaskSSE(__m128i s) {
+    const __m128i c0 = _mm_setr_epi8(0, 0, 0, 3, 3, 3, 6, 6, 6, 9, 9, 9, 12, 12, 12, -128);
+    const __m128i c1 = _mm_setr_epi8(1, 1, 1, 4, 4, 4, 7, 7, 7, 10, 10, 10, 13, 13, 13, -128);
+    const __m128i c2 = _mm_setr_epi8(2, 2, 2, 5, 5, 5, 8, 8, 8, 11, 11, 11, 14, 14, 14, -128);
+    __m128i nz = _mm_xor_si128(_mm_cmpeq_epi8(s, _mm_setzero_si128()), _mm_set1_epi8(-1));
+    return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(nz, c0), _mm_shuffle_epi8(nz, c1)),
+                        _mm_shuffle_epi8(nz, c2));
+}
+
+__attribute__((target("sse4.1")))
+static void overlaySSE41(uint8_t* dst, const uint8_t* src, int pixels, int opacity) {
+    const __m128i a = _mm_set1_epi16(static_cast<short>(opacity));
+    int x = 0;
+    for (; pixels - x >= 6; x += 5) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x * 3));
+        __m128i r = blendMaskedSSE(s, d, pixelMaskSSE(s), a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 3), r);
+    }
+    overlayScalar(dst + x * 3, src + x * 3, pixels - x, opacity);
+}
+
+// AVX2 overlay: two 5-pixel groups per iteration, one per 128-bit lane. The
+// lanes overlap by one byte in memory, so the low lane is stored first and the
+// high lane (which holds the blended value of that byte) overwrites it.
+__attribute__((target("avx2")))
+static void overlayAVX2(uint8_t* dst, const uint8_t* src, int pixels, int opacity) {
+    const __m256i c0 = _mm256_setr_epi8(0, 0, 0, 3, 3, 3, 6, 6, 6, 9, 9, 9, 12, 12, 12, -128,
+                                        0, 0, 0, 3, 3, 3, 6, 6, 6, 9, 9, 9, 12, 12, 12, -128);
+    const __m256i c1 = _mm256_setr_epi8(1, 1, 1, 4, 4, 4, 7, 7, 7, 10, 10, 10, 13, 13, 13, -128,
+                                        1, 1, 1, 4, 4, 4, 7, 7, 7, 10, 10, 10, 13, 13, 13, -128);
+    const __m256i c2 = _mm256_setr_epi8(2, 2, 2, 5, 5, 5, 8, 8, 8, 11, 11, 11, 14, 14, 14, -128,
+                                        2, 2, 2, 5, 5, 5, 8, 8, 8, 11, 11, 11, 14, 14, 14, -128);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i a = _mm256_set1_epi16(static_cast<short>(opacity));
+    const __m256i full = _mm256_set1_epi16(256);
+    const __m256i round = _mm256_set1_epi16(128);
+
+    int x = 0;
+    for (; pixels - x >= 11; x += 10) {
+        const uint8_t* sp = src + x * 3;
+        uint8_t* dp = dst + x * 3;
+        __m256i s = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sp))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(sp + 15)), 1);
+        __m256i d = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dp))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(dp + 15)), 1);
+
+        __m256i nz = _mm256_xor_si256(_mm256_cmpeq_epi8(s, zero), _mm256_set1_epi8(-1));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(nz, c0),
+                                                    _mm256_shuffle_epi8(nz, c1)),
+                                    _mm256_shuffle_epi8(nz, c2));
+
+        __m256i alo = _mm256_and_si256(_mm256_unpacklo_epi8(m, m), a);
+        __m256i ahi = _mm256_and_si256(_mm256_unpackhi_epi8(m, m), a);
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), alo),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero),
+                                                         _mm256_sub_epi16(full, alo)));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), ahi),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero),
+                                                         _mm256_sub_epi16(full, ahi)));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+        __m256i r = _mm256_packus_epi16(lo, hi);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dp), _mm256_castsi256_si128(r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dp + 15), _mm256_extracti128_si256(r, 1));
+    }
+    overlaySSE41(dst + x * 3, src + x * 3, pixels - x, opacity);
+}
+
+#elif BLEND_NEON
+
+// NEON de-interleaves BGR natively, so kernels work on 8 whole pixels
+static inline uint8x8_t mix8NEON(uint8x8_t s, uint8x8_t d, uint16x8_t a) {
+    uint16x8_t ia = vsubq_u16(vdupq_n_u16(256), a);
+    uint16x8_t r = vaddq_u16(vmulq_u16(vmovl_u8(s), a), vmulq_u16(vmovl_u8(d), ia));
+    return vshrn_n_u16(vaddq_u16(r, vdupq_n_u16(128)), 8);
+}
+
+static void overlayNEON(uint8_t* dst, const uint8_t* src, int pixels, int opacity) {
+    const uint16x8_t a = vdupq_n_u16(static_cast<uint16_t>(opacity));
+    int x = 0;
+    for (; pixels - x >= 8; x += 8) {
+        uint8x8x3_t s = vld3_u8(src + x * 3);
+        uint8x8x3_t d = vld3_u8(dst + x * 3);
+        uint8x8_t any = vorr_u8(vorr_u8(s.val[0], s.val[1]), s.val[2]);
+        uint8x8_t m = vtst_u8(any, any);
+        uint16x8_t w = vandq_u16(vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(m))), a);
+        uint8x8x3_t r;
+        r.val[0] = mix8NEON(s.val[0], d.val[0], w);
+        r.val[1] = mix8NEON(s.val[1], d.val[1], w);
+        r.val[2] = mix8NEON(s.val[2], d.val[2], w);
+        vst3_u8(dst + x * 3, r);
+    }
+    overlayScalar(dst + x * 3, src + x * 3, pixels - x, opacity);
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+// ---------------------------------------------------------------------------
+
+struct BlendKernels {
+    void (*overlay)(uint8_t*, const uint8_t*, int, int);
+    const char* name;
+};
+
+static BlendKernels selectKernels() {
+#if BLEND_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {overlayAVX2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return {overlaySSE41, "sse4.1"};
+    }
+#elif BLEND_NEON
+    return {overlayNEON, "neon"};
+#endif
+    return {overlayScalar, "scalar"};
+}
+
+static const BlendKernels& kernels() {
+    static const BlendKernels selected = selectKernels();
+    return selected;
+}
+
+void blendOverlayBGR(uint8_t* dst, const uint8_t* src, int pixels, int opacity) {
+    if (pixels > 0) kernels().overlay(dst, src, pixels, opacity);
+}
+
+const char* blendKernelName() {
+    return kernels().name;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-point 8-bit alpha compositing for packed BGR rows.
+// Weights are in 1/256 units (0 = keep destination, 256 = take source), so
+// every kernel computes (src * a + dst * (256 - a) + 128) >> 8 per channel.
+// The fastest kernel supported by the running CPU is selected on first use:
+// AVX2 or SSE4.1 on x86, NEON on ARM, portable scalar code otherwise.
+
+// Blend src over dst with constant opacity, but only where the src pixel is
+// non-black (black = transparent). Used to overlay the matrix layer.
+void blendOverlayBGR(uint8_t* dst, const uint8_t* src, int pixels, int opacity);
+
+// Name of the selected kernel ("avx2", "sse4.1", "neon" or "scalar")
+const char* blendKernelName();
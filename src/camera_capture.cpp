@@ -1,6 +1,6 @@
 #include "camera_capture.h"
+#include "stage_stats.h"
 #include <iostream>
-#include <filesystem>
 #include <algorithm>
 #include <set>
 #include <fcntl.h>
@@ -8,6 +8,10 @@
 #include <sys/ioctl.h>
 #include <linux/videodev2.h>
 
+static bool isJpegFormat(uint32_t pixelFormat) {
+    return pixelFormat == V4L2_PIX_FMT_MJPEG || pixelFormat == V4L2_PIX_FMT_JPEG;
+}
+
 CameraCapture::~CameraCapture() {
     close();
 }
@@ -65,8 +69,8 @@ std::vector<ResolutionMode> CameraCapture::queryResolutions(const std::string& d
     return result;
 }
 
-bool CameraCapture::setResolution(Resolution resPref) {
-    auto resolutions = queryResolutions(device_);
+bool CameraCapture::selectResolution(Resolution resPref, ResolutionMode& selected) {
+    auto resolutions = knownResolutions_.empty() ? queryResolutions(device_) : knownResolutions_;
 
     if (resolutions.empty()) {
         std::cerr << "Could not query camera resolutions" << std::endl;
@@ -80,7 +84,6 @@ bool CameraCapture::setResolution(Resolution resPref) {
     }
 
     // Select resolution based on preference
-    ResolutionMode selected;
     size_t count = resolutions.size();
 
     switch (resPref) {
@@ -103,6 +106,14 @@ bool CameraCapture::setResolution(Resolution resPref) {
     }
 
     std::cout << "Selected resolution: " << selected.width << "x" << selected.height << std::endl;
+    return true;
+}
+
+bool CameraCapture::setResolution(Resolution resPref) {
+    ResolutionMode selected;
+    if (!selectResolution(resPref, selected)) {
+        return false;
+    }
 
     // For higher resolutions, use MJPG format (camera may not support YUYV at high res)
     if (selected.width > 640 || selected.height > 480) {
@@ -125,31 +136,62 @@ bool CameraCapture::setResolution(Resolution resPref) {
     return true;
 }
 
-bool CameraCapture::detectCamera(Resolution resPref) {
-    // Try /dev/video0 through /dev/video9
-    for (int i = 0; i < 10; ++i) {
-        std::string device = "/dev/video" + std::to_string(i);
-        if (std::filesystem::exists(device)) {
-            cv::VideoCapture testCap(device, cv::CAP_V4L2);
-            if (testCap.isOpened()) {
-                // Check if this is a capture device (not output-only)
-                cv::Mat testFrame;
-                if (testCap.read(testFrame) && !testFrame.empty()) {
-                    testCap.release();
-                    return open(device, resPref);
-                }
-                testCap.release();
-            }
+void CameraCapture::setBackend(CaptureBackend backend, int bufferCount) {
+    backend_ = backend;
+    bufferCount_ = bufferCount;
+}
+
+void CameraCapture::setMjpegDecoder(MjpegDecoderType type) {
+    decoderType_ = type;
+    decoder_.reset();
+}
+
+bool CameraCapture::openNative(Resolution resPref) {
+    ResolutionMode selected;
+    if (!selectResolution(resPref, selected)) {
+        return false;
+    }
+
+    if (!native_.open(device_, selected.width, selected.height, bufferCount_)) {
+        return false;
+    }
+
+    width_ = native_.getWidth();
+    height_ = native_.getHeight();
+    if (width_ != selected.width || height_ != selected.height) {
+        std::cout << "Note: Camera set to " << width_ << "x" << height_
+                  << " (requested " << selected.width << "x" << selected.height << ")" << std::endl;
+    }
+
+    fps_ = native_.getFPS();
+    if (fps_ <= 0 || fps_ > 120) {
+        fps_ = 30.0;  // Default to 30 FPS if invalid
+    }
+
+    if (isJpegFormat(native_.getPixelFormat())) {
+        if (!decoder_) {
+            decoder_ = createMjpegDecoder(decoderType_);
         }
+        std::cout << "MJPEG decoder: " << decoder_->name() << std::endl;
     }
-    std::cerr << "No camera detected" << std::endl;
-    return false;
+
+    std::cout << "Resolution: " << width_ << "x" << height_ << " @ " << fps_ << " FPS" << std::endl;
+    return true;
 }
 
 bool CameraCapture::open(const std::string& device, Resolution resPref) {
     close();
 
     device_ = device;
+
+    if (backend_ == CaptureBackend::V4L2) {
+        if (openNative(resPref)) {
+            std::cout << "Opened camera: " << device << " (native V4L2)" << std::endl;
+            return true;
+        }
+        std::cerr << "Native V4L2 capture failed on " << device << ", falling back to OpenCV" << std::endl;
+    }
+
     cap_.open(device, cv::CAP_V4L2);
 
     if (!cap_.isOpened()) {
@@ -177,11 +219,98 @@ bool CameraCapture::open(const std::string& device, Resolution resPref) {
 }
 
 cv::Mat CameraCapture::captureFrame() {
-    cv::Mat frame;
-    if (cap_.isOpened()) {
-        cap_ >> frame;
+    if (!grab()) {
+        return cv::Mat();
     }
-    return frame;
+    return retrieve();
+}
+
+bool CameraCapture::grab() {
+    StageTimer timer(Stage::CAPTURE);
+    rawValid_ = false;
+    if (native_.isOpened()) {
+        // Generous timeout: some cameras take a while to deliver the first frame
+        rawValid_ = native_.dequeue(raw_, 2000);
+        return rawValid_;
+    }
+    return cap_.isOpened() && cap_.grab();
+}
+
+bool CameraCapture::retrieveRaw(RawFrame& frame) const {
+    if (!rawValid_) {
+        return false;
+    }
+    frame = raw_;
+    return true;
+}
+
+bool CameraCapture::retrieveYUYV(cv::Mat& view) const {
+    if (!rawValid_ || raw_.pixelFormat != V4L2_PIX_FMT_YUYV) {
+        return false;
+    }
+
+    size_t step = raw_.bytesPerLine ? raw_.bytesPerLine : static_cast<size_t>(raw_.width) * 2;
+    if (raw_.size < step * raw_.height) {
+        return false;  // Short frame
+    }
+
+    view = cv::Mat(raw_.height, raw_.width, CV_8UC2, const_cast<uint8_t*>(raw_.data), step);
+    return true;
+}
+
+cv::Mat CameraCapture::retrieve() {
+    if (!retrieveTo(decoded_)) {
+        return cv::Mat();
+    }
+    return decoded_;
+}
+
+bool CameraCapture::retrieveTo(cv::Mat& dst) {
+    StageTimer timer(Stage::DECODE);
+    if (!native_.isOpened()) {
+        return cap_.isOpened() && cap_.retrieve(dst) && !dst.empty();
+    }
+
+    if (!rawValid_) {
+        return false;
+    }
+
+    switch (raw_.pixelFormat) {
+        case V4L2_PIX_FMT_YUYV: {
+            cv::Mat yuyv;
+            if (!retrieveYUYV(yuyv)) {
+                return false;
+            }
+            cv::cvtColor(yuyv, dst, cv::COLOR_YUV2BGR_YUYV);
+            break;
+        }
+        case V4L2_PIX_FMT_MJPEG:
+        case V4L2_PIX_FMT_JPEG:
+            if (!decoder_ || !decoder_->decodeBGR(raw_.data, raw_.size, dst)) {
+                return false;
+            }
+            break;
+        default:
+            std::cerr << "Unsupported capture format: " << V4L2Capture::fourccToString(raw_.pixelFormat) << std::endl;
+            return false;
+    }
+    return true;
+}
+
+bool CameraCapture::canDecodeYUYV(int dstW, int dstH) const {
+    return decoder_ && native_.isOpened() && decoder_->canDecodeYUYV(width_, height_, dstW, dstH);
+}
+
+bool CameraCapture::decodeYUYV(cv::Mat& dst) {
+    if (!rawValid_ || !decoder_ || !isJpegFormat(raw_.pixelFormat)) {
+        return false;
+    }
+    StageTimer timer(Stage::DECODE);
+    return decoder_->decodeYUYV(raw_.data, raw_.size, dst);
+}
+
+uint32_t CameraCapture::getPixelFormat() const {
+    return native_.isOpened() ? native_.getPixelFormat() : 0;
 }
 
 void CameraCapture::getResolution(int& width, int& height) const {
@@ -194,10 +323,19 @@ double CameraCapture::getFPS() const {
 }
 
 bool CameraCapture::isOpened() const {
-    return cap_.isOpened();
+    return native_.isOpened() || cap_.isOpened();
+}
+
+void CameraCapture::flush() {
+    rawValid_ = false;
+    if (native_.isOpened()) {
+        native_.flush();
+    }
 }
 
 void CameraCapture::close() {
+    rawValid_ = false;
+    native_.close();
     if (cap_.isOpened()) {
         cap_.release();
     }
@@ -4,6 +4,10 @@
 #include <string>
 #include <vector>
 #include "config.h"
+#include "v4l2_capture.h"
+#include "mjpeg_decoder.h"
+#include "frame_source.h"
+#include <memory>
 
 struct ResolutionMode {
     int width;
@@ -17,23 +21,62 @@ struct ResolutionMode {
     }
 };
 
-class CameraCapture {
+class CameraCapture : public FrameSource {
 public:
     CameraCapture() = default;
-    ~CameraCapture();
+    ~CameraCapture() override;
+
+    // Applies to the next open()
+    void setBackend(CaptureBackend backend, int bufferCount = 3);
+    void setMjpegDecoder(MjpegDecoderType type);
+    // Modes from an earlier query (see DeviceManager), so open() doesn't
+    // enumerate them again; kept until replaced, empty = query
+    void setKnownResolutions(std::vector<ResolutionMode> modes) { knownResolutions_ = std::move(modes); }
 
-    bool detectCamera(Resolution resPref = Resolution::HIGH);
     bool open(const std::string& device, Resolution resPref = Resolution::HIGH);
     cv::Mat captureFrame();
+
+    // Two-step capture: grab() waits for the next frame, then either look at
+    // the undecoded driver buffer (native backend only) or decode it to BGR.
+    // Both stay valid until the next grab().
+    bool grab() override;
+    bool retrieveRaw(RawFrame& frame) const;
+    bool retrieveYUYV(cv::Mat& view) const override;   // Header over a raw YUYV buffer, no copy
+    cv::Mat retrieve() override;
+    bool retrieveTo(cv::Mat& dst);                      // Decode into a caller-owned BGR frame
+
+    // Decode a raw MJPEG frame straight into a YUYV destination (e.g. an
+    // output driver buffer), downscaling in the DCT domain when possible.
+    // canDecodeYUYV() tells beforehand whether dstW x dstH is reachable.
+    bool canDecodeYUYV(int dstW, int dstH) const override;
+    bool decodeYUYV(cv::Mat& dst) override;
+
     void getResolution(int& width, int& height) const;
+    uint32_t getPixelFormat() const;   // V4L2 fourcc of raw frames, 0 when not native
     double getFPS() const;
     bool isOpened() const;
     void close();
 
+    // Drop frames buffered while nobody grabbed (native backend), e.g. after
+    // keeping the stream open through a consumer disconnect
+    void flush();
+
     static std::vector<ResolutionMode> queryResolutions(const std::string& device);
 
 private:
+    bool selectResolution(Resolution resPref, ResolutionMode& selected);
     bool setResolution(Resolution resPref);
+    bool openNative(Resolution resPref);
+
+    CaptureBackend backend_ = CaptureBackend::V4L2;
+    int bufferCount_ = 3;
+    std::vector<ResolutionMode> knownResolutions_;
+    V4L2Capture native_;
+    RawFrame raw_;
+    bool rawValid_ = false;
+    cv::Mat decoded_;                   // Reused BGR decode target
+    MjpegDecoderType decoderType_ = MjpegDecoderType::AUTO;
+    std::unique_ptr<MjpegDecoder> decoder_;   // Created lazily for MJPEG streams
 
     cv::VideoCapture cap_;
     int width_ = 0;
@@ -0,0 +1,114 @@
+#include "capture_thread.h"
+#include <iostream>
+#include <chrono>
+#include <linux/videodev2.h>
+
+// Same patience as a native dequeue: some cameras are slow to start
+static constexpr int GRAB_TIMEOUT_MS = 2000;
+static constexpr int GRAB_POLL_MS = 100;
+
+CaptureThread::CaptureThread(int depth) : ring_(depth) {}
+
+CaptureThread::~CaptureThread() {
+    stop();
+}
+
+void CaptureThread::start(CameraCapture& camera, int outputWidth, int outputHeight) {
+    stop();
+
+    camera_ = &camera;
+    outputWidth_ = outputWidth;
+    outputHeight_ = outputHeight;
+
+    int camWidth, camHeight;
+    camera.getResolution(camWidth, camHeight);
+    directYUYV_ = camera.getPixelFormat() == V4L2_PIX_FMT_YUYV &&
+                  camWidth == outputWidth && camHeight == outputHeight;
+    directMJPEG_ = camera.canDecodeYUYV(outputWidth, outputHeight);
+
+    ring_.reset();
+    current_ = nullptr;
+    stop_.store(false);
+    failed_.store(false);
+    thread_ = std::thread(&CaptureThread::run, this);
+}
+
+void CaptureThread::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    stop_.store(true);
+    thread_.join();
+    ring_.releaseRead();
+    current_ = nullptr;
+    camera_ = nullptr;
+}
+
+void CaptureThread::run() {
+    // Before the first frame is allocated, so ring slots land on our node
+    applyPlacement("capture", placement_);
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        if (!camera_->grab()) {
+            failed_.store(true);
+            ring_.notify();
+            return;
+        }
+
+        cv::Mat& frame = ring_.acquireWrite();
+        bool ok = false;
+        if (!preferBGR_.load(std::memory_order_relaxed)) {
+            cv::Mat view;
+            if (directYUYV_ && camera_->retrieveYUYV(view)) {
+                // Copy out so the driver buffer goes back straight away
+                view.copyTo(frame);
+                ok = true;
+            } else if (directMJPEG_) {
+                frame.create(outputHeight_, outputWidth_, CV_8UC2);
+                ok = camera_->decodeYUYV(frame);
+            }
+        }
+        if (!ok) {
+            ok = camera_->retrieveTo(frame);
+        }
+
+        // A failed decode keeps the slot for the next frame
+        if (ok) {
+            ring_.publish();
+        }
+    }
+}
+
+bool CaptureThread::grab() {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(GRAB_TIMEOUT_MS);
+    do {
+        current_ = ring_.acquireRead(GRAB_POLL_MS);
+        if (current_) {
+            return true;
+        }
+    } while (!failed_.load() && isRunning() && std::chrono::steady_clock::now() < deadline);
+
+    if (!failed_.load()) {
+        std::cerr << "Capture thread timeout" << std::endl;
+    }
+    return false;
+}
+
+bool CaptureThread::retrieveYUYV(cv::Mat& view) const {
+    if (!current_ || current_->type() != CV_8UC2) {
+        return false;
+    }
+    view = *current_;
+    return true;
+}
+
+cv::Mat CaptureThread::retrieve() {
+    if (!current_) {
+        return cv::Mat();
+    }
+    if (current_->type() == CV_8UC2) {
+        cv::cvtColor(*current_, bgr_, cv::COLOR_YUV2BGR_YUYV);
+        return bgr_;
+    }
+    return *current_;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <thread>
+#include "camera_capture.h"
+#include "frame_ring.h"
+#include "thread_placement.h"
+#include "frame_source.h"
+
+// Capture stage of the pipeline: grabs and decodes camera frames on its own
+// thread, ahead of the render loop. Frames arrive as YUYV at the output size
+// when the camera can deliver that cheaply (raw YUYV or direct MJPEG decode),
+// BGR otherwise. If the render loop falls behind, the oldest queued frame is
+// dropped.
+class CaptureThread : public FrameSource {
+public:
+    explicit CaptureThread(int depth);
+    ~CaptureThread() override;
+
+    // camera must stay open and untouched by other threads until stop()
+    void start(CameraCapture& camera, int outputWidth, int outputHeight);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+    void setPlacement(const ThreadPlacement& placement) { placement_ = placement; }  // From the next start()
+
+    // Effects that draw over the camera image want BGR; decoding straight to
+    // it saves a YUYV round trip
+    void setPreferBGR(bool prefer) { preferBGR_.store(prefer, std::memory_order_relaxed); }
+
+    bool grab() override;
+    bool retrieveYUYV(cv::Mat& view) const override;
+    cv::Mat retrieve() override;
+    bool canDecodeYUYV(int, int) const override { return false; }  // Already decoded
+    bool decodeYUYV(cv::Mat&) override { return false; }
+
+    uint64_t getDropped() const { return ring_.getDropped(); }
+
+private:
+    void run();
+
+    FrameRing<cv::Mat> ring_;
+    CameraCapture* camera_ = nullptr;
+    int outputWidth_ = 0;
+    int outputHeight_ = 0;
+    bool directYUYV_ = false;       // Raw YUYV at the output size
+    bool directMJPEG_ = false;      // MJPEG decodable straight to the output size
+
+    ThreadPlacement placement_;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> failed_{false};
+    std::atomic<bool> preferBGR_{false};
+
+    cv::Mat* current_ = nullptr;    // Frame lent out by grab()
+    cv::Mat bgr_;                   // YUYV -> BGR for retrieve()
+};
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
 
 enum class Resolution {
     LOW,
@@ -9,9 +10,64 @@ enum class Resolution {
     HIGH
 };
 
+enum class CaptureBackend {
+    V4L2,       // Native mmap streaming (raw buffers, no forced BGR decode)
+    OPENCV      // cv::VideoCapture
+};
+
+enum class MjpegDecoderType {
+    AUTO,       // libjpeg(-turbo) when available, otherwise OpenCV
+    LIBJPEG,
+    OPENCV      // cv::imdecode
+};
+
+enum class StaticMode {
+    CACHED,     // Pre-rendered frames, mmapped from the on-disk cache
+    PROCEDURAL  // Composited from glyph tiles every frame, no frame cache
+};
+
+// How frames are resampled when the camera and output sizes differ
+enum class ScaleFilter {
+    NEAREST,    // Fastest, blocky
+    BILINEAR,   // Smooth; aliases on large reductions
+    AREA        // Averages every covered pixel when shrinking, bilinear when enlarging
+};
+
+// Matrix rain colours
+enum class ColorTheme {
+    GREEN,      // The film's phosphor green
+    AMBER,
+    CYAN,
+    RED,
+    WHITE
+};
+
+// Real-time scheduling class for the pipeline threads
+enum class RealtimePolicy {
+    NONE,       // SCHED_OTHER
+    FIFO,       // SCHED_FIFO
+    RR          // SCHED_RR
+};
+
+// One step of the effect sequence, run when an effect triggers
+struct EffectStep {
+    std::string name;                       // EffectRegistry name
+    uint64_t duration = 0;                  // milliseconds
+};
+
+// One virtual camera from --output; a zero size means the camera's
+struct OutputTarget {
+    std::string device;
+    int width = 0;
+    int height = 0;
+};
+
 struct Config {
     std::string inputDevice = "";           // Empty = auto-detect
-    std::string outputDevice = "/dev/video2";
+    std::string outputDevice = "/dev/video2";  // First of outputs
+    std::vector<OutputTarget> outputs;         // Every --output device (filled by parseArgs)
+    std::string inputSpec;                  // Headless source instead of a camera (see FileSource)
+    std::string sinkSpec = "v4l2";          // Output backend: v4l2, file:<path>, shm:<name>
     uint64_t minInterval = 60000;           // milliseconds (default 1 minute)
     uint64_t maxInterval = 3600000;         // milliseconds (default 60 minutes)
     uint64_t effectDuration = 5000;         // milliseconds
@@ -22,18 +78,39 @@ struct Config {
     Resolution resolution = Resolution::HIGH;  // Camera resolution preference
     bool onDemand = true;                   // Only open camera when virtual camera has consumers
     uint64_t cameraPollInterval = 1000;     // ms between camera availability checks
+    uint64_t cameraLinger = 0;              // ms to keep the camera open after the last consumer leaves
+    uint64_t idleInterval = 1000;           // ms between repeated static frames while nobody watches
     bool overlay = false;                   // Overlay matrix on camera feed instead of black background
+    int outputBuffers = 3;                  // mmap ring size for the virtual camera (0 = use write())
+    CaptureBackend captureBackend = CaptureBackend::V4L2;  // Falls back to OpenCV if native open fails
+    int captureBuffers = 3;                 // Native capture buffer ring size (fewer = lower latency)
+    MjpegDecoderType mjpegDecoder = MjpegDecoderType::AUTO;
+    int pipelineDepth = 2;                  // Frames queued between pipeline threads (0 = single-threaded)
+    StaticMode staticMode = StaticMode::CACHED;
+    ScaleFilter scaleFilter = ScaleFilter::BILINEAR;  // Camera to output resampling
+    ColorTheme colorTheme = ColorTheme::GREEN;  // Matrix rain colours
+    uint32_t seed = 0;                      // Effect RNG seed for reproducible frames (0 = random)
+    int renderThreads = 0;                  // Matrix render threads (0 = one per core, 1 = render thread only)
+    std::vector<int> captureCpus;           // CPUs for the capture thread (empty = unpinned)
+    std::vector<int> renderCpus;            // CPUs for the render loop and its workers
+    std::vector<int> outputCpus;            // CPUs for the output thread
+    RealtimePolicy realtimePolicy = RealtimePolicy::NONE;
+    int realtimePriority = 10;              // 1-99, with realtimePolicy
+    bool lockMemory = false;                // mlockall so frame buffers never page out
+    uint64_t statsInterval = 0;             // ms between stats lines (0 = off)
+    std::string statsSocket;                // Unix socket serving Prometheus stats (empty = off)
+    std::vector<EffectStep> effectSequence; // Filled by parseArgs (default: static, matrix)
 };
 
 enum class EffectState {
     PASSTHROUGH,
-    STATIC,
-    MATRIX
+    EFFECT          // Running config.effectSequence
 };
 
 enum class CameraState {
     IDLE,           // No consumers, camera closed
     CONNECTING,     // Consumers present, trying to open camera
     ACTIVE,         // Camera open and working
-    UNAVAILABLE     // Camera busy/unavailable, polling
+    UNAVAILABLE,    // Camera busy/unavailable, polling
+    LINGER          // No consumers, camera kept streaming for a quick reconnect
 };
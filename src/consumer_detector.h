@@ -3,9 +3,15 @@
 #include <string>
 #include <filesystem>
 #include <fstream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <cstdio>
 #include <cstring>
+#include <cstdlib>
 #include <sys/stat.h>
 
 class ConsumerDetector {
@@ -27,35 +33,65 @@ public:
     }
 
     // Check if any process (other than us) has the virtual camera open
-    bool hasConsumers() const {
+    bool hasConsumers() {
+        return getConsumerCount() > 0;
+    }
+
+    // Get count of consumers (approximate)
+    int getConsumerCount() {
         // Method 1: Check sysfs for reader count (faster if available)
         int sysfsCount = checkSysfs();
         if (sysfsCount >= 0) {
-            // sysfs reports count, subtract 1 for our own writer
-            return sysfsCount > 1;
+            return std::max(0, sysfsCount - 1);  // Subtract our writer
         }
 
         // Method 2: Scan /proc for file descriptors (fallback)
-        return checkProcFd();
+        return scanProc();
     }
 
-    // Get count of consumers (approximate)
-    int getConsumerCount() const {
-        int sysfsCount = checkSysfs();
-        if (sysfsCount >= 0) {
-            return std::max(0, sysfsCount - 1);  // Subtract our writer
-        }
-        return countProcFdConsumers();
+    // Something opened the device: make the next /proc scan re-read every
+    // process instead of trusting the cache
+    void requestFullScan() {
+        fullScanRequested_ = true;
     }
 
 private:
+    // What the last /proc scan learned about one process
+    struct ProcEntry {
+        uint64_t startTime = 0;     // From /proc/<pid>/stat, tells a reused PID apart
+        long fdCount = -1;          // Open fds in /proc/<pid>/fd (-1 = unknown)
+        int deviceFd = -1;          // fd holding our device, -1 if none
+        bool readable = true;       // false if its fds can't be listed (other user)
+        uint32_t generation = 0;    // Last scan that saw it
+    };
+
+    // Processes whose fd count is unchanged are skipped, which misses one that
+    // closed a file and opened the device in between; re-read all this often
+    static constexpr int FULL_SCAN_EVERY = 10;
+
     std::string devicePath_;
     std::string deviceName_;
     ino_t deviceInode_ = 0;
     dev_t deviceDev_ = 0;
 
+    std::string sysfsPath_;             // open_count file found last time
+    std::unordered_map<long, ProcEntry> procCache_;
+    uint32_t generation_ = 0;
+    int scansSinceFull_ = 0;
+    bool fullScanRequested_ = true;
+
     // Check sysfs for open count (v4l2loopback specific)
-    int checkSysfs() const {
+    int checkSysfs() {
+        if (!sysfsPath_.empty()) {
+            std::ifstream f(sysfsPath_);
+            if (f.is_open()) {
+                int count = 0;
+                f >> count;
+                return count;
+            }
+            sysfsPath_.clear();
+        }
+
         // Try various sysfs paths that v4l2loopback might expose
         std::vector<std::string> paths = {
             "/sys/devices/virtual/video4linux/" + deviceName_ + "/open_count",
@@ -68,92 +104,180 @@ private:
             if (f.is_open()) {
                 int count = 0;
                 f >> count;
+                sysfsPath_ = path;
                 return count;
             }
         }
         return -1;  // Not available
     }
 
-    // Scan /proc/*/fd for processes with our device open
-    bool checkProcFd() const {
-        pid_t ourPid = getpid();
-        DIR* procDir = opendir("/proc");
-        if (!procDir) return false;
+    bool isDevice(const struct stat& st) const {
+        return S_ISCHR(st.st_mode) && st.st_rdev == deviceDev_;
+    }
 
-        struct dirent* entry;
-        while ((entry = readdir(procDir)) != nullptr) {
-            // Skip non-numeric entries
-            if (entry->d_type != DT_DIR) continue;
+    // Field 22 of /proc/<pid>/stat, in clock ticks since boot
+    static uint64_t readStartTime(int procFd, long pid) {
+        char path[64];
+        snprintf(path, sizeof(path), "%ld/stat", pid);
+        int fd = openat(procFd, path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return 0;
 
-            char* endptr;
-            long pid = strtol(entry->d_name, &endptr, 10);
-            if (*endptr != '\0') continue;  // Not a number
+        char buf[1024];
+        ssize_t len = read(fd, buf, sizeof(buf) - 1);
+        ::close(fd);
+        if (len <= 0) return 0;
+        buf[len] = '\0';
 
-            // Skip our own process
-            if (pid == ourPid) continue;
+        // The command name may contain spaces or parentheses; fields resume
+        // after the last ')' with field 3 (state)
+        char* p = strrchr(buf, ')');
+        if (!p) return 0;
+        for (int field = 2; field < 22 && p; ++field) {
+            p = strchr(p + 1, ' ');
+        }
+        return p ? strtoull(p + 1, nullptr, 10) : 0;
+    }
 
-            // Check this process's file descriptors
-            std::string fdPath = "/proc/" + std::string(entry->d_name) + "/fd";
-            DIR* fdDir = opendir(fdPath.c_str());
-            if (!fdDir) continue;
-
-            struct dirent* fdEntry;
-            while ((fdEntry = readdir(fdDir)) != nullptr) {
-                std::string linkPath = fdPath + "/" + fdEntry->d_name;
-                char target[PATH_MAX];
-                ssize_t len = readlink(linkPath.c_str(), target, sizeof(target) - 1);
-                if (len > 0) {
-                    target[len] = '\0';
-                    if (std::string(target) == devicePath_) {
-                        closedir(fdDir);
-                        closedir(procDir);
-                        return true;
-                    }
-                }
+    // Number of entries in a process's fd directory, -1 if it can't be listed
+    static long countFds(int procFd, const char* fdDirPath) {
+        int dirFd = openat(procFd, fdDirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd < 0) return -1;
+        DIR* fdDir = fdopendir(dirFd);
+        if (!fdDir) {
+            ::close(dirFd);
+            return -1;
+        }
+        long count = 0;
+        struct dirent* fdEntry;
+        while ((fdEntry = readdir(fdDir)) != nullptr) {
+            if (fdEntry->d_name[0] != '.') ++count;
+        }
+        closedir(fdDir);
+        return count;
+    }
+
+    // Scan one process's fds; returns the fd holding our device, or -1
+    int findDeviceFd(int procFd, const char* fdDirPath, bool& readable) const {
+        int dirFd = openat(procFd, fdDirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd < 0) {
+            readable = (errno != EACCES && errno != EPERM);
+            return -1;
+        }
+        readable = true;
+
+        DIR* fdDir = fdopendir(dirFd);
+        if (!fdDir) {
+            ::close(dirFd);
+            return -1;
+        }
+
+        int found = -1;
+        struct dirent* fdEntry;
+        while ((fdEntry = readdir(fdDir)) != nullptr) {
+            if (fdEntry->d_name[0] == '.') continue;
+
+            // stat() follows the fd link to the file it refers to
+            struct stat st;
+            if (fstatat(dirFd, fdEntry->d_name, &st, 0) == 0 && isDevice(st)) {
+                found = atoi(fdEntry->d_name);
+                break;
             }
-            closedir(fdDir);
         }
-        closedir(procDir);
-        return false;
+        closedir(fdDir);
+        return found;
     }
 
-    // Count consumers via /proc (more expensive)
-    int countProcFdConsumers() const {
-        pid_t ourPid = getpid();
-        int count = 0;
+    // Count processes with our device open. Processes are keyed by PID and
+    // start time; known consumers only need one stat() to confirm, others are
+    // re-read when new, when their fd count changed, or on a full scan.
+    int scanProc() {
+        if (deviceDev_ == 0) {
+            // Device node may have appeared since construction (module loaded late)
+            struct stat st;
+            if (stat(devicePath_.c_str(), &st) != 0) return 0;
+            deviceInode_ = st.st_ino;
+            deviceDev_ = st.st_rdev;
+        }
 
         DIR* procDir = opendir("/proc");
         if (!procDir) return 0;
+        int procFd = dirfd(procDir);
+
+        bool fullScan = fullScanRequested_ || ++scansSinceFull_ >= FULL_SCAN_EVERY;
+        if (fullScan) {
+            fullScanRequested_ = false;
+            scansSinceFull_ = 0;
+        }
+
+        ++generation_;
+        pid_t ourPid = getpid();
+        int count = 0;
+        char path[64];
 
         struct dirent* entry;
         while ((entry = readdir(procDir)) != nullptr) {
+            // Skip non-numeric entries
             if (entry->d_type != DT_DIR) continue;
 
             char* endptr;
             long pid = strtol(entry->d_name, &endptr, 10);
-            if (*endptr != '\0') continue;
+            if (*endptr != '\0') continue;  // Not a number
+
+            // Skip our own process
             if (pid == ourPid) continue;
 
-            std::string fdPath = "/proc/" + std::string(entry->d_name) + "/fd";
-            DIR* fdDir = opendir(fdPath.c_str());
-            if (!fdDir) continue;
-
-            struct dirent* fdEntry;
-            while ((fdEntry = readdir(fdDir)) != nullptr) {
-                std::string linkPath = fdPath + "/" + fdEntry->d_name;
-                char target[PATH_MAX];
-                ssize_t len = readlink(linkPath.c_str(), target, sizeof(target) - 1);
-                if (len > 0) {
-                    target[len] = '\0';
-                    if (std::string(target) == devicePath_) {
-                        count++;
-                        break;  // Count each process once
-                    }
+            // A changed start time means the PID was reused: forget the old process
+            ProcEntry& proc = procCache_[pid];
+            uint64_t startTime = readStartTime(procFd, pid);
+            bool isNew = (proc.generation == 0 || proc.startTime != startTime);
+            if (isNew) {
+                proc = ProcEntry();
+                proc.startTime = startTime;
+            }
+            proc.generation = generation_;
+
+            // Still holding the device on the same fd?
+            if (proc.deviceFd >= 0) {
+                struct stat st;
+                snprintf(path, sizeof(path), "%ld/fd/%d", pid, proc.deviceFd);
+                if (fstatat(procFd, path, &st, 0) == 0 && isDevice(st)) {
+                    count++;
+                    continue;
                 }
             }
-            closedir(fdDir);
+
+            snprintf(path, sizeof(path), "%ld/fd", pid);
+            struct stat fdDirStat;
+            if (fstatat(procFd, path, &fdDirStat, 0) != 0) {
+                proc.deviceFd = -1;
+                continue;  // Exited
+            }
+            // Linux 6.2+ reports the fd count as the directory size; older
+            // kernels report 0, so count the entries (still no stat() per fd)
+            long fdCount = fdDirStat.st_size > 0 ? static_cast<long>(fdDirStat.st_size)
+                                                 : countFds(procFd, path);
+
+            if (!isNew && !fullScan && proc.deviceFd < 0 &&
+                (!proc.readable || (fdCount >= 0 && fdCount == proc.fdCount))) {
+                continue;  // Nothing to suggest it changed
+            }
+
+            proc.fdCount = fdCount;
+            proc.deviceFd = findDeviceFd(procFd, path, proc.readable);
+            if (proc.deviceFd >= 0) {
+                count++;
+            }
         }
         closedir(procDir);
+
+        // Forget processes that have exited
+        for (auto it = procCache_.begin(); it != procCache_.end();) {
+            if (it->second.generation != generation_) {
+                it = procCache_.erase(it);
+            } else {
+                ++it;
+            }
+        }
         return count;
     }
 };
@@ -0,0 +1,135 @@
+#include "consumer_monitor.h"
+#include "thread_placement.h"
+#include <iostream>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+
+// Bursts of open/close events (a consumer probing formats) share one check
+static constexpr int MIN_CHECK_INTERVAL_MS = 100;
+
+// Safety net for opens that produce no inotify event
+static constexpr int FALLBACK_CHECK_INTERVAL_MS = 1000;
+
+static uint64_t monotonicMs() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
+ConsumerMonitor::ConsumerMonitor(const std::string& devicePath)
+    : devicePath_(devicePath), detector_(devicePath) {}
+
+ConsumerMonitor::~ConsumerMonitor() {
+    stop();
+}
+
+void ConsumerMonitor::start() {
+    stop();
+
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ >= 0) {
+        watchFd_ = inotify_add_watch(inotifyFd_, devicePath_.c_str(), IN_OPEN | IN_CLOSE);
+    }
+    if (watchFd_ < 0) {
+        std::cerr << "Warning: can't watch " << devicePath_ << " (" << strerror(errno)
+                  << "), polling for consumers" << std::endl;
+    }
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    refresh();
+    stop_.store(false);
+    thread_ = std::thread(&ConsumerMonitor::run, this);
+}
+
+void ConsumerMonitor::stop() {
+    if (thread_.joinable()) {
+        stop_.store(true);
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t r = write(wakeFd_, &one, sizeof(one));
+        thread_.join();
+    }
+
+    if (inotifyFd_ >= 0) {
+        ::close(inotifyFd_);  // Also drops the watch
+    }
+    if (wakeFd_ >= 0) {
+        ::close(wakeFd_);
+    }
+    inotifyFd_ = watchFd_ = wakeFd_ = -1;
+}
+
+void ConsumerMonitor::refresh() {
+    int count = detector_.getConsumerCount();
+    if (consumerCount_.exchange(count, std::memory_order_relaxed) != count) {
+        {
+            std::lock_guard<std::mutex> lock(changeMutex_);
+            changeCount_++;
+        }
+        changeCv_.notify_all();
+    }
+}
+
+uint64_t ConsumerMonitor::getChangeCount() {
+    std::lock_guard<std::mutex> lock(changeMutex_);
+    return changeCount_;
+}
+
+bool ConsumerMonitor::waitForChange(uint64_t seen, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(changeMutex_);
+    return changeCv_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                              [seen] { return changeCount_ != seen; });
+}
+
+void ConsumerMonitor::run() {
+    applyBackgroundPlacement("consumer monitor");
+    uint64_t lastCheck = monotonicMs();
+    bool pending = false;
+
+    while (!stop_.load()) {
+        uint64_t now = monotonicMs();
+        uint64_t elapsed = now - lastCheck;
+        uint64_t interval = pending ? MIN_CHECK_INTERVAL_MS : FALLBACK_CHECK_INTERVAL_MS;
+        int timeout = elapsed >= interval ? 0 : static_cast<int>(interval - elapsed);
+
+        struct pollfd fds[2] = {
+            {wakeFd_, POLLIN, 0},
+            {watchFd_ >= 0 ? inotifyFd_ : -1, POLLIN, 0}
+        };
+        int r = poll(fds, 2, timeout);
+        if (r < 0 && errno != EINTR) {
+            std::cerr << "Consumer monitor poll failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        if (stop_.load()) {
+            break;
+        }
+
+        if (r > 0 && (fds[1].revents & POLLIN)) {
+            // A close can only end a known consumer; an open may be any process
+            alignas(struct inotify_event) char buf[4096];
+            ssize_t len;
+            while ((len = read(inotifyFd_, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + len;) {
+                    auto* event = reinterpret_cast<struct inotify_event*>(p);
+                    if (event->mask & IN_OPEN) {
+                        detector_.requestFullScan();
+                    }
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+            pending = true;
+        }
+
+        now = monotonicMs();
+        elapsed = now - lastCheck;
+        if ((pending && elapsed >= MIN_CHECK_INTERVAL_MS) || elapsed >= FALLBACK_CHECK_INTERVAL_MS) {
+            refresh();
+            lastCheck = now;
+            pending = false;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "consumer_detector.h"
+
+// Tracks whether anything has the virtual camera open without scanning on
+// the main loop. A background thread watches the device node with inotify
+// (IN_OPEN / IN_CLOSE) and re-checks only when something happened, plus a
+// slow periodic scan for opens inotify can't see (other mount namespaces,
+// or no inotify at all). The main loop just reads the cached state.
+class ConsumerMonitor {
+public:
+    explicit ConsumerMonitor(const std::string& devicePath);
+    ~ConsumerMonitor();
+
+    ConsumerMonitor(const ConsumerMonitor&) = delete;
+    ConsumerMonitor& operator=(const ConsumerMonitor&) = delete;
+
+    // Checks once synchronously, so the state is valid on return
+    void start();
+    void stop();
+
+    bool hasConsumers() const { return consumerCount_.load(std::memory_order_relaxed) > 0; }
+    int getConsumerCount() const { return consumerCount_.load(std::memory_order_relaxed); }
+    bool isEventDriven() const { return watchFd_ >= 0; }
+
+    // Bumped whenever any monitor's consumer count changes. Read it before
+    // checking hasConsumers(), then waitForChange() sleeps without missing
+    // a change in between.
+    static uint64_t getChangeCount();
+    // Returns true if the count moved past seen before timeoutMs
+    static bool waitForChange(uint64_t seen, int timeoutMs);
+
+private:
+    void run();
+    void refresh();
+
+    std::string devicePath_;
+    ConsumerDetector detector_;         // Only used by the monitor thread after start()
+    int inotifyFd_ = -1;
+    int watchFd_ = -1;
+    int wakeFd_ = -1;                   // eventfd to interrupt poll() on stop()
+
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<int> consumerCount_{0};
+
+    static inline std::mutex changeMutex_;
+    static inline std::condition_variable changeCv_;
+    static inline uint64_t changeCount_ = 0;    // Guarded by changeMutex_
+};
@@ -0,0 +1,242 @@
+#include "device_manager.h"
+#include "thread_placement.h"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <linux/videodev2.h>
+
+// udev creates the node, then fixes its permissions; wait for things to settle
+static constexpr int HOTPLUG_SETTLE_MS = 200;
+
+// "/dev/video12" -> 12, -1 for anything that isn't a video node
+static int videoIndex(const std::string& name) {
+    if (name.rfind("video", 0) != 0 || name.size() == 5) {
+        return -1;
+    }
+    char* end = nullptr;
+    long index = std::strtol(name.c_str() + 5, &end, 10);
+    return *end == '\0' ? static_cast<int>(index) : -1;
+}
+
+// v4l2loopback nodes (our own outputs among them) have no physical parent,
+// so skip them without opening, which would look like a consumer
+static bool isVirtualNode(const std::string& name) {
+    char resolved[PATH_MAX];
+    std::string link = "/sys/class/video4linux/" + name;
+    return realpath(link.c_str(), resolved) && std::strstr(resolved, "/virtual/") != nullptr;
+}
+
+DeviceManager::~DeviceManager() {
+    stop();
+}
+
+void DeviceManager::start() {
+    stop();
+
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ >= 0 && inotify_add_watch(inotifyFd_, "/dev", IN_CREATE | IN_DELETE | IN_ATTRIB) < 0) {
+        ::close(inotifyFd_);
+        inotifyFd_ = -1;
+    }
+    if (inotifyFd_ < 0) {
+        std::cerr << "Warning: can't watch /dev (" << strerror(errno)
+                  << "), rescanning cameras on every open" << std::endl;
+        return;
+    }
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    stop_.store(false);
+    watchThread_ = std::thread(&DeviceManager::run, this);
+}
+
+void DeviceManager::stop() {
+    cancelOpen();
+
+    if (watchThread_.joinable()) {
+        stop_.store(true);
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t r = write(wakeFd_, &one, sizeof(one));
+        watchThread_.join();
+    }
+    if (inotifyFd_ >= 0) {
+        ::close(inotifyFd_);
+    }
+    if (wakeFd_ >= 0) {
+        ::close(wakeFd_);
+    }
+    inotifyFd_ = wakeFd_ = -1;
+}
+
+void DeviceManager::run() {
+    applyBackgroundPlacement("device watch");
+    bool pending = false;
+
+    while (!stop_.load()) {
+        struct pollfd fds[2] = {
+            {wakeFd_, POLLIN, 0},
+            {inotifyFd_, POLLIN, 0}
+        };
+        int r = poll(fds, 2, pending ? HOTPLUG_SETTLE_MS : -1);
+        if (r < 0 && errno != EINTR) {
+            std::cerr << "Device watch poll failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        if (stop_.load()) {
+            break;
+        }
+
+        if (r > 0 && (fds[1].revents & POLLIN)) {
+            alignas(struct inotify_event) char buf[4096];
+            ssize_t len;
+            while ((len = read(inotifyFd_, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + len;) {
+                    auto* event = reinterpret_cast<struct inotify_event*>(p);
+                    if (event->len > 0 && videoIndex(event->name) >= 0) {
+                        pending = true;
+                    }
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+            continue;  // Settle: wait for a quiet period
+        }
+
+        if (r == 0 && pending) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                dirty_ = true;
+            }
+            changeCount_.fetch_add(1, std::memory_order_relaxed);
+            pending = false;
+        }
+    }
+}
+
+bool DeviceManager::describe(const std::string& path, Device& device) const {
+    device.path = path;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        return false;
+    }
+    struct v4l2_capability cap{};
+    bool ok = ioctl(fd, VIDIOC_QUERYCAP, &cap) == 0;
+    ::close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    device.card = reinterpret_cast<const char*>(cap.card);
+    device.key = std::string(reinterpret_cast<const char*>(cap.driver)) + "/" + device.card + "/" +
+                 reinterpret_cast<const char*>(cap.bus_info);
+
+    // Flags of this node rather than the whole physical device
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    return (caps & V4L2_CAP_VIDEO_CAPTURE) && (caps & V4L2_CAP_STREAMING) && !(caps & V4L2_CAP_VIDEO_OUTPUT);
+}
+
+std::vector<DeviceManager::Device> DeviceManager::getCaptureDevices() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_ && inotifyFd_ >= 0) {
+        return devices_;
+    }
+
+    std::vector<std::pair<int, std::string>> nodes;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/dev", ec)) {
+        std::string name = entry.path().filename().string();
+        int index = videoIndex(name);
+        if (index >= 0 && !isVirtualNode(name)) {
+            nodes.emplace_back(index, entry.path().string());
+        }
+    }
+    std::sort(nodes.begin(), nodes.end());
+
+    devices_.clear();
+    for (const auto& node : nodes) {
+        Device device;
+        if (describe(node.second, device)) {
+            devices_.push_back(device);
+        }
+    }
+    dirty_ = false;
+    return devices_;
+}
+
+std::vector<ResolutionMode> DeviceManager::getResolutions(const Device& device) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = capabilities_.find(device.key);
+        if (it != capabilities_.end()) {
+            return it->second;
+        }
+    }
+
+    std::vector<ResolutionMode> modes = CameraCapture::queryResolutions(device.path);
+    if (!modes.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capabilities_[device.key] = modes;
+    }
+    return modes;
+}
+
+bool DeviceManager::openCamera(CameraCapture& camera, const std::string& device, Resolution resPref) {
+    std::vector<Device> candidates;
+    if (!device.empty()) {
+        // Explicitly chosen: try it whatever its flags say
+        Device chosen;
+        describe(device, chosen);
+        if (chosen.key.empty()) chosen.key = device;
+        candidates.push_back(chosen);
+    } else {
+        candidates = getCaptureDevices();
+        if (candidates.empty()) {
+            std::cerr << "No camera detected" << std::endl;
+            return false;
+        }
+    }
+
+    for (const auto& candidate : candidates) {
+        camera.setKnownResolutions(getResolutions(candidate));
+        if (camera.open(candidate.path, resPref)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DeviceManager::openAsync(CameraCapture& camera, const std::string& device, Resolution resPref) {
+    cancelOpen();
+    openState_.store(OpenState::RUNNING);
+    openThread_ = std::thread([this, &camera, device, resPref] {
+        applyBackgroundPlacement("camera open");
+        openSuccess_ = openCamera(camera, device, resPref);
+        openState_.store(OpenState::DONE);
+    });
+}
+
+bool DeviceManager::takeOpenResult(bool& success) {
+    if (openState_.load() != OpenState::DONE) {
+        return false;
+    }
+    openThread_.join();
+    success = openSuccess_;
+    openState_.store(OpenState::NONE);
+    return true;
+}
+
+void DeviceManager::cancelOpen() {
+    if (openThread_.joinable()) {
+        openThread_.join();
+    }
+    openState_.store(OpenState::NONE);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include "config.h"
+#include "camera_capture.h"
+
+// Finds cameras without touching their streams: capture nodes are told
+// apart by VIDIOC_QUERYCAP flags (loopback and metadata nodes are skipped),
+// and the resolution list of each camera is cached by driver, card and bus,
+// so a camera re-plugged on another /dev/videoN is not probed again.
+// A background thread watches /dev with inotify for hot-plug, and opening a
+// camera can run on a worker thread while the main loop keeps streaming.
+class DeviceManager {
+public:
+    struct Device {
+        std::string path;           // /dev/videoN
+        std::string card;
+        std::string key;            // driver/card/bus_info, stable across re-plugs
+    };
+
+    DeviceManager() = default;
+    ~DeviceManager();
+
+    DeviceManager(const DeviceManager&) = delete;
+    DeviceManager& operator=(const DeviceManager&) = delete;
+
+    void start();
+    void stop();
+
+    // Capture devices present now, in /dev/videoN order
+    std::vector<Device> getCaptureDevices();
+
+    // Bumped when video nodes appear or disappear
+    uint64_t getChangeCount() const { return changeCount_.load(std::memory_order_relaxed); }
+
+    // Open device, or the first capture device that opens if it's empty
+    bool openCamera(CameraCapture& camera, const std::string& device, Resolution resPref);
+
+    // The same on a worker thread. camera belongs to it until the result is
+    // taken or cancelOpen() returns.
+    void openAsync(CameraCapture& camera, const std::string& device, Resolution resPref);
+    bool isOpening() const { return openState_.load() == OpenState::RUNNING; }
+    bool takeOpenResult(bool& success);     // False while running or if nothing was started
+    void cancelOpen();                      // Waits for a running open, drops its result
+
+private:
+    enum class OpenState { NONE, RUNNING, DONE };
+
+    bool describe(const std::string& path, Device& device) const;
+    std::vector<ResolutionMode> getResolutions(const Device& device);
+    void run();
+
+    std::mutex mutex_;
+    std::vector<Device> devices_;           // Guarded by mutex_
+    bool dirty_ = true;                     // Rescan before the next lookup (guarded by mutex_)
+    std::map<std::string, std::vector<ResolutionMode>> capabilities_;  // By Device::key
+
+    int inotifyFd_ = -1;
+    int wakeFd_ = -1;
+    std::thread watchThread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> changeCount_{0};
+
+    std::thread openThread_;
+    std::atomic<OpenState> openState_{OpenState::NONE};
+    bool openSuccess_ = false;              // Written by the worker before DONE
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+// Layout of the frame an effect renders into
+enum class PixelFormat {
+    BGR24,      // CV_8UC3
+    YUYV,       // CV_8UC2, BT.601 limited range (the virtual camera's format)
+    GRAY8       // CV_8UC1
+};
+
+// How an effect's pixels combine with the camera frame
+enum class BlendMode {
+    REPLACE,    // Effect fills the frame
+    OVERLAY     // Non-black effect pixels blended over the camera frame
+};
+
+inline int pixelFormatType(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::BGR24: return CV_8UC3;
+        case PixelFormat::YUYV:  return CV_8UC2;
+        case PixelFormat::GRAY8: return CV_8UC1;
+    }
+    return CV_8UC3;
+}
+
+// One step of the effect sequence. update() advances the animation once per
+// output frame; renderInto() only draws. Effects are created by name through
+// EffectRegistry, so the main loop never needs to know the concrete types.
+class Effect {
+public:
+    virtual ~Effect() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool initialize(int width, int height) = 0;
+    virtual void update(uint64_t currentTimeMs) = 0;
+    virtual void reset() = 0;   // Start over when the effect is triggered
+
+    // Draw a getWidth() x getHeight() frame into dst, which is only
+    // (re)allocated if its size or type doesn't match format. For OVERLAY,
+    // background is a BGR camera frame of any size; effects that don't
+    // support overlaying ignore it and draw as REPLACE.
+    virtual void renderInto(cv::Mat& dst, PixelFormat format,
+                            BlendMode mode = BlendMode::REPLACE,
+                            const cv::Mat& background = cv::Mat(), float opacity = 0.9f) = 0;
+    virtual bool supportsOverlay() const { return false; }
+
+    virtual int getWidth() const = 0;
+    virtual int getHeight() const = 0;
+};
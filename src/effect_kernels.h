@@ -0,0 +1,82 @@
+#pragma once
+
+#include "effect.h"
+#include "blend.h"
+#include "pixel_convert.h"
+#include <cstring>
+#include <type_traits>
+
+// Row kernels shared by effects, templated on output format and blend mode so
+// every combination compiles to its own loop with no format or mode checks
+// inside it. Effects pick the instantiation once per frame via dispatchRender.
+
+template <PixelFormat F>
+using FormatTag = std::integral_constant<PixelFormat, F>;
+template <BlendMode M>
+using BlendTag = std::integral_constant<BlendMode, M>;
+
+// Call fn(FormatTag<F>{}, BlendTag<M>{}) for the runtime format and mode
+template <typename Fn>
+inline void dispatchRender(PixelFormat format, BlendMode mode, Fn&& fn) {
+    const bool overlay = (mode == BlendMode::OVERLAY);
+    switch (format) {
+        case PixelFormat::BGR24:
+            overlay ? fn(FormatTag<PixelFormat::BGR24>{}, BlendTag<BlendMode::OVERLAY>{})
+                    : fn(FormatTag<PixelFormat::BGR24>{}, BlendTag<BlendMode::REPLACE>{});
+            break;
+        case PixelFormat::YUYV:
+            overlay ? fn(FormatTag<PixelFormat::YUYV>{}, BlendTag<BlendMode::OVERLAY>{})
+                    : fn(FormatTag<PixelFormat::YUYV>{}, BlendTag<BlendMode::REPLACE>{});
+            break;
+        case PixelFormat::GRAY8:
+            overlay ? fn(FormatTag<PixelFormat::GRAY8>{}, BlendTag<BlendMode::OVERLAY>{})
+                    : fn(FormatTag<PixelFormat::GRAY8>{}, BlendTag<BlendMode::REPLACE>{});
+            break;
+    }
+}
+
+// Write one row of a palette-indexed effect layer as format F. For OVERLAY
+// the layer's non-black pixels are blended over background (a BGR row) with
+// weight in 1/256 units. scratch holds pixels * 6 bytes: the coloured layer
+// row and, for formats other than BGR, the blended row.
+template <PixelFormat F, BlendMode M>
+inline void composePaletteRow(uint8_t* dst, const uint8_t* layer, const uint8_t* background,
+                              uint8_t* scratch, int pixels, int weight, const ColorPalette& palette) {
+    if constexpr (M == BlendMode::OVERLAY) {
+        uint8_t* colored = scratch;
+        uint8_t* mixed = (F == PixelFormat::BGR24) ? dst : scratch + static_cast<size_t>(pixels) * 3;
+        paletteRowToBGR(layer, colored, pixels, palette);
+        if (mixed != background) {
+            std::memcpy(mixed, background, static_cast<size_t>(pixels) * 3);
+        }
+        blendOverlayBGR(mixed, colored, pixels, weight);
+        if constexpr (F == PixelFormat::YUYV) {
+            bgrRowToYUYV(mixed, dst, pixels);
+        } else if constexpr (F == PixelFormat::GRAY8) {
+            bgrRowToGray(mixed, dst, pixels);
+        }
+    } else if constexpr (F == PixelFormat::BGR24) {
+        paletteRowToBGR(layer, dst, pixels, palette);
+    } else if constexpr (F == PixelFormat::YUYV) {
+        paletteRowToYUYV(layer, dst, pixels, palette);
+    } else {
+        paletteRowToGray(layer, dst, pixels, palette);
+    }
+}
+
+// Write one row of a grayscale layer as format F (grayscale effects are
+// opaque, so there is no blend mode)
+template <PixelFormat F>
+inline void composeGrayRow(uint8_t* dst, const uint8_t* gray, int pixels) {
+    if constexpr (F == PixelFormat::GRAY8) {
+        if (gray != dst) {
+            std::memcpy(dst, gray, pixels);
+        }
+    } else if constexpr (F == PixelFormat::YUYV) {
+        grayRowToYUYV(gray, dst, pixels);
+    } else {
+        for (int x = 0; x < pixels; ++x, dst += 3) {
+            dst[0] = dst[1] = dst[2] = gray[x];
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include "effect_registry.h"
+#include "static_effect.h"
+#include "matrix_effect.h"
+
+EffectRegistry::EffectRegistry() {
+    add("static", [](const Config& config) {
+        auto effect = std::make_unique<StaticEffect>();
+        effect->setMode(config.staticMode);
+        if (config.seed) effect->setSeed(config.seed);
+        return std::unique_ptr<Effect>(std::move(effect));
+    });
+    add("matrix", [](const Config& config) {
+        auto effect = std::make_unique<MatrixEffect>();
+        effect->setRenderThreads(config.renderThreads);
+        effect->setScaleFilter(config.scaleFilter);
+        effect->setTheme(config.colorTheme);
+        if (config.seed) effect->setSeed(config.seed);
+        return std::unique_ptr<Effect>(std::move(effect));
+    });
+}
+
+EffectRegistry& EffectRegistry::instance() {
+    static EffectRegistry registry;
+    return registry;
+}
+
+void EffectRegistry::add(const std::string& name, Factory factory) {
+    factories_[name] = std::move(factory);
+}
+
+bool EffectRegistry::has(const std::string& name) const {
+    return factories_.count(name) > 0;
+}
+
+std::unique_ptr<Effect> EffectRegistry::create(const std::string& name, const Config& config) const {
+    auto it = factories_.find(name);
+    if (it == factories_.end()) {
+        return nullptr;
+    }
+    return it->second(config);
+}
+
+std::vector<std::string> EffectRegistry::getNames() const {
+    std::vector<std::string> names;
+    for (const auto& entry : factories_) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "effect.h"
+
+// Effects by name, for --effects and the effect sequence. The built-in
+// effects are registered when the registry is first used; add() makes new
+// ones available without touching the main loop.
+class EffectRegistry {
+public:
+    using Factory = std::function<std::unique_ptr<Effect>(const Config& config)>;
+
+    static EffectRegistry& instance();
+
+    void add(const std::string& name, Factory factory);
+    bool has(const std::string& name) const;
+    std::unique_ptr<Effect> create(const std::string& name, const Config& config) const;  // nullptr if unknown
+    std::vector<std::string> getNames() const;
+
+private:
+    EffectRegistry();
+
+    std::map<std::string, Factory> factories_;
+};
@@ -0,0 +1,155 @@
+#include "fan_out_sink.h"
+#include "stage_stats.h"
+#include <iostream>
+
+FanOutSink::~FanOutSink() {
+    close();
+}
+
+bool FanOutSink::open(const std::vector<OutputTarget>& targets, int width, int height, double fps,
+                      int bufferCount) {
+    close();
+
+    for (const auto& target : targets) {
+        Output output;
+        output.sink = std::make_unique<VirtualOutput>();
+        if (!output.sink->open(target.device, target.width ? target.width : width,
+                               target.height ? target.height : height, fps, bufferCount)) {
+            close();
+            return false;
+        }
+        output.monitor = std::make_unique<ConsumerMonitor>(target.device);
+        // Outputs already run in parallel; nested bands would queue on the shared pool
+        output.scaler.setParallel(targets.size() == 1);
+        output.sink->setCountFrames(false);
+        outputs_.push_back(std::move(output));
+    }
+    if (outputs_.empty()) {
+        return false;
+    }
+
+    // Effects render once, at the largest size; the rest are scaled down
+    for (const auto& output : outputs_) {
+        int w = output.sink->getWidth();
+        int h = output.sink->getHeight();
+        if (static_cast<int64_t>(w) * h > static_cast<int64_t>(width_) * height_) {
+            width_ = w;
+            height_ = h;
+        }
+    }
+    staging_.create(height_, width_, CV_8UC2);
+    active_.reserve(outputs_.size());
+    if (outputs_.size() > 1) {
+        pool_ = std::make_unique<ThreadPool>(static_cast<int>(outputs_.size()) - 1);
+    }
+
+    std::cout << "Fan-out to " << outputs_.size() << " outputs, rendering at "
+              << width_ << "x" << height_ << std::endl;
+    return true;
+}
+
+void FanOutSink::close() {
+    pool_.reset();
+    for (auto& output : outputs_) {
+        output.monitor->stop();
+        output.sink->close();
+    }
+    outputs_.clear();
+    active_.clear();
+    monitoring_ = false;
+    width_ = height_ = 0;
+    staging_.release();
+}
+
+void FanOutSink::startMonitors() {
+    for (auto& output : outputs_) {
+        output.monitor->start();
+    }
+    monitoring_ = true;
+}
+
+bool FanOutSink::hasConsumers() const {
+    if (!monitoring_) {
+        return true;
+    }
+    for (const auto& output : outputs_) {
+        if (output.monitor->hasConsumers()) return true;
+    }
+    return false;
+}
+
+bool FanOutSink::isEventDriven() const {
+    for (const auto& output : outputs_) {
+        if (!output.monitor->isEventDriven()) return false;
+    }
+    return true;
+}
+
+bool FanOutSink::selectActive() {
+    active_.clear();
+    for (auto& output : outputs_) {
+        if (!monitoring_ || !output.primed || output.monitor->hasConsumers()) {
+            active_.push_back(&output);
+        }
+    }
+    return !active_.empty();
+}
+
+template <typename Fn>
+void FanOutSink::forEachActive(Fn&& fn) {
+    if (active_.size() == 1 || !pool_) {
+        for (Output* output : active_) fn(*output);
+    } else {
+        pool_->parallelFor(static_cast<int>(active_.size()), [&](int i) { fn(*active_[i]); });
+    }
+    for (Output* output : active_) {
+        output->primed = true;
+    }
+    // One frame, however many outputs it went to
+    StageStats::instance().add(Counter::FRAMES);
+}
+
+// Scale and convert straight into the output's next buffer
+void FanOutSink::writeScaled(Output& output, const cv::Mat& frame) {
+    {
+        StageTimer timer(Stage::CONVERT);
+        output.scaler.toYUYV(frame, output.sink->acquireBuffer());
+    }
+    output.sink->commitBuffer();
+}
+
+void FanOutSink::writeFrame(const cv::Mat& frame) {
+    if (frame.empty() || !selectActive()) {
+        return;
+    }
+    forEachActive([&](Output& output) { writeScaled(output, frame); });
+}
+
+void FanOutSink::writeFrameYUYV(const cv::Mat& yuyv) {
+    if (yuyv.empty() || yuyv.cols != width_ || yuyv.rows != height_ || !selectActive()) {
+        return;
+    }
+
+    // Smaller outputs are resampled as YUYV, with no BGR round trip
+    forEachActive([&](Output& output) {
+        if (output.sink->getWidth() == width_ && output.sink->getHeight() == height_) {
+            output.sink->writeFrameYUYV(yuyv);
+        } else {
+            writeScaled(output, yuyv);
+        }
+    });
+}
+
+cv::Mat& FanOutSink::acquireBuffer() {
+    return staging_;
+}
+
+void FanOutSink::commitBuffer() {
+    writeFrameYUYV(staging_);
+}
+
+void FanOutSink::setScaleFilter(ScaleFilter filter) {
+    for (auto& output : outputs_) {
+        output.scaler.setFilter(filter);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <vector>
+#include "config.h"
+#include "frame_sink.h"
+#include "virtual_output.h"
+#include "consumer_monitor.h"
+#include "thread_pool.h"
+
+// Sends every frame to several virtual cameras, each with its own consumer
+// monitor and negotiated size. Frames arrive once at the largest output's
+// size; scaling, conversion and the write then run per output in parallel,
+// each output's scaler on its own task rather than the shared pool.
+// Outputs nobody has open are skipped, after their first frame has made the
+// device readable.
+class FanOutSink : public FrameSink {
+public:
+    FanOutSink() = default;
+    ~FanOutSink() override;
+
+    bool open(const std::vector<OutputTarget>& targets, int width, int height, double fps, int bufferCount);
+    void close();
+
+    // Consumer tracking for every output; without it all outputs are written
+    void startMonitors();
+    bool hasConsumers() const;
+    bool isEventDriven() const;
+
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+
+    void writeFrame(const cv::Mat& frame) override;
+    void writeFrameYUYV(const cv::Mat& yuyv) override;
+    cv::Mat& acquireBuffer() override;
+    void commitBuffer() override;
+    void setScaleFilter(ScaleFilter filter) override;
+
+private:
+    struct Output {
+        std::unique_ptr<VirtualOutput> sink;
+        std::unique_ptr<ConsumerMonitor> monitor;
+        FrameScaler scaler;             // To this output's size, on the fan-out task
+        bool primed = false;            // Has had a frame, so consumers can open it
+    };
+
+    bool selectActive();
+    template <typename Fn> void forEachActive(Fn&& fn);
+    void writeScaled(Output& output, const cv::Mat& frame);
+
+    std::vector<Output> outputs_;
+    std::vector<Output*> active_;       // Outputs written this frame
+    std::unique_ptr<ThreadPool> pool_;  // One worker per output beyond the first
+    bool monitoring_ = false;
+    int width_ = 0;
+    int height_ = 0;
+
+    cv::Mat staging_;                   // acquireBuffer() frame, YUYV at our size
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <random>
+
+// Cheap, well-mixed 32-bit hash (lowbias32), so any cell of any frame can be
+// derived independently without keeping RNG state
+inline uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// Counter-based generator for the effects: value i of a stream is
+// hash32(key + i * golden ratio). Equal seeds give equal streams, and batches
+// have no loop-carried state, so fill() vectorizes. Period is 2^32 per seed,
+// plenty for visuals but not meant for anything else.
+class FastRng {
+public:
+    explicit FastRng(uint32_t seed) { setSeed(seed); }
+    FastRng() : FastRng(std::random_device{}()) {}
+
+    void setSeed(uint32_t seed) {
+        key_ = hash32(seed ^ 0x5bd1e995U);
+        counter_ = 0;
+    }
+
+    uint32_t next() { return hash32(key_ + counter_++ * STEP); }
+
+    // Uniform in [0, n) by multiply-shift instead of modulo
+    static uint32_t scale(uint32_t random, uint32_t n) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(random) * n) >> 32);
+    }
+    uint32_t below(uint32_t n) { return scale(next(), n); }
+    int range(int lo, int hi) { return lo + static_cast<int>(below(static_cast<uint32_t>(hi - lo + 1))); }
+
+    // count consecutive stream values, same as calling next() count times
+    void fill(uint32_t* out, size_t count) {
+        const uint32_t key = key_;
+        const uint32_t base = counter_;
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = hash32(key + (base + static_cast<uint32_t>(i)) * STEP);
+        }
+        counter_ += static_cast<uint32_t>(count);
+    }
+
+private:
+    static constexpr uint32_t STEP = 0x9e3779b9U;
+
+    uint32_t key_ = 0;
+    uint32_t counter_ = 0;
+};
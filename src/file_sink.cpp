@@ -0,0 +1,90 @@
+#include "file_sink.h"
+#include "stage_stats.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+FileSink::~FileSink() {
+    close();
+}
+
+bool FileSink::open(const std::string& path, int width, int height) {
+    close();
+    if (path == "-") {
+        fd_ = STDOUT_FILENO;
+    } else {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        ownsFd_ = true;
+    }
+    width_ = width;
+    height_ = height;
+    broken_.store(false, std::memory_order_relaxed);
+    buffer_.create(height_, width_, CV_8UC2);
+    return true;
+}
+
+void FileSink::close() {
+    if (ownsFd_ && fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    ownsFd_ = false;
+}
+
+bool FileSink::writeAll(const uint8_t* data, size_t size) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    StageTimer timer(Stage::WRITE);
+    while (size > 0) {
+        ssize_t n = write(fd_, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            // EPIPE: the reader exited (SIGPIPE is ignored by main)
+            std::cerr << "Output write failed: " << strerror(errno) << std::endl;
+            StageStats::instance().add(Counter::WRITE_ERRORS);
+            broken_.store(true, std::memory_order_relaxed);
+            close();
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    StageStats::instance().add(Counter::FRAMES);
+    return true;
+}
+
+void FileSink::writeFrame(const cv::Mat& frame) {
+    if (fd_ < 0 || frame.empty()) {
+        return;
+    }
+
+    {
+        StageTimer timer(Stage::CONVERT);
+        scaler_.toYUYV(frame, buffer_);
+    }
+    commitBuffer();
+}
+
+void FileSink::writeFrameYUYV(const cv::Mat& yuyv) {
+    if (yuyv.empty() || yuyv.cols != width_ || yuyv.rows != height_ || yuyv.type() != CV_8UC2) {
+        return;
+    }
+    if (yuyv.isContinuous()) {
+        writeAll(yuyv.data, yuyv.total() * 2);
+        return;
+    }
+    yuyv.copyTo(buffer_);
+    commitBuffer();
+}
+
+void FileSink::commitBuffer() {
+    writeAll(buffer_.data, buffer_.total() * 2);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <atomic>
+#include "frame_sink.h"
+
+// Headless sink: packed YUYV frames written back to back to a file or pipe
+// ("-" = stdout), e.g. for ffmpeg -f rawvideo -pix_fmt yuyv422.
+class FileSink : public FrameSink {
+public:
+    FileSink() = default;
+    ~FileSink() override;
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    bool open(const std::string& path, int width, int height);
+    void close();
+    bool isOpened() const { return fd_ >= 0; }
+    // The reader went away or a write failed; safe to poll from another thread
+    bool isBroken() const { return broken_.load(std::memory_order_relaxed); }
+
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+
+    void writeFrame(const cv::Mat& frame) override;
+    void writeFrameYUYV(const cv::Mat& yuyv) override;
+    cv::Mat& acquireBuffer() override { return buffer_; }
+    void commitBuffer() override;
+
+private:
+    bool writeAll(const uint8_t* data, size_t size);
+
+    int fd_ = -1;
+    bool ownsFd_ = false;
+    std::atomic<bool> broken_{false};
+    int width_ = 0;
+    int height_ = 0;
+    cv::Mat buffer_;                // Continuous, so a frame is one write
+};
@@ -0,0 +1,169 @@
+#include "file_source.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+FileSource::~FileSource() {
+    close();
+}
+
+// "<W>x<H>" -> width, height
+static bool parseSize(const std::string& text, int& width, int& height) {
+    return std::sscanf(text.c_str(), "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+}
+
+// The pattern becomes a printf format: allow exactly one %d (optionally
+// %0Nd or %Nd) plus literal %%, nothing that could read other arguments
+static bool isValidPattern(const std::string& pattern) {
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] != '%') continue;
+        if (++i < pattern.size() && pattern[i] == '%') continue;
+        while (i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9') ++i;
+        if (i >= pattern.size() || pattern[i] != 'd') return false;
+        ++conversions;
+    }
+    return conversions == 1;
+}
+
+bool FileSource::open(const std::string& spec) {
+    close();
+
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string rest = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+    if (kind == "images") {
+        if (!isValidPattern(rest)) {
+            std::cerr << "Invalid image pattern: " << rest << " (needs exactly one %d, e.g. frames/%04d.png)"
+                      << std::endl;
+            return false;
+        }
+        format_ = Format::IMAGES;
+        pattern_ = rest;
+        // Sequences may be numbered from 0 or from 1
+        for (nextImage_ = 0; nextImage_ <= 1; ++nextImage_) {
+            cv::Mat first = cv::imread(imagePath(nextImage_), cv::IMREAD_COLOR);
+            if (!first.empty()) {
+                width_ = first.cols;
+                height_ = first.rows;
+                return true;
+            }
+        }
+        std::cerr << "No images found for " << pattern_ << std::endl;
+        pattern_.clear();
+        return false;
+    }
+
+    if (kind != "yuyv" && kind != "nv12") {
+        std::cerr << "Unknown input format: " << kind << " (use yuyv, nv12 or images)" << std::endl;
+        return false;
+    }
+    format_ = kind == "yuyv" ? Format::YUYV : Format::NV12;
+
+    size_t sizeEnd = rest.find(':');
+    if (sizeEnd == std::string::npos || !parseSize(rest.substr(0, sizeEnd), width_, height_)) {
+        std::cerr << "Input needs a size: " << kind << ":<W>x<H>:<path>" << std::endl;
+        return false;
+    }
+    if ((width_ & 1) || (format_ == Format::NV12 && (height_ & 1))) {
+        std::cerr << "Input size must be even for " << kind << std::endl;
+        return false;
+    }
+
+    std::string path = rest.substr(sizeEnd + 1);
+    if (path == "-") {
+        fd_ = STDIN_FILENO;
+    } else {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        ownsFd_ = true;
+    }
+
+    if (format_ == Format::YUYV) {
+        raw_.create(height_, width_, CV_8UC2);
+    } else {
+        raw_.create(height_ * 3 / 2, width_, CV_8UC1);
+    }
+    return true;
+}
+
+void FileSource::close() {
+    if (ownsFd_ && fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    ownsFd_ = false;
+    pattern_.clear();
+    bgrValid_ = false;
+}
+
+std::string FileSource::imagePath(int index) const {
+    char path[4096];
+    std::snprintf(path, sizeof(path), pattern_.c_str(), index);
+    return path;
+}
+
+bool FileSource::readFrame() {
+    // Pipes hand out partial frames; keep reading until one is complete
+    uint8_t* dst = raw_.data;
+    size_t remaining = raw_.total() * raw_.elemSize();
+    while (remaining > 0) {
+        ssize_t n = read(fd_, dst, remaining);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (n < 0) {
+                std::cerr << "Input read failed: " << strerror(errno) << std::endl;
+            }
+            return false;  // A trailing partial frame is dropped
+        }
+        dst += n;
+        remaining -= n;
+    }
+    return true;
+}
+
+bool FileSource::grab() {
+    bgrValid_ = false;
+    if (format_ == Format::IMAGES) {
+        if (pattern_.empty()) {
+            return false;
+        }
+        bgr_ = cv::imread(imagePath(nextImage_), cv::IMREAD_COLOR);
+        if (bgr_.empty()) {
+            return false;
+        }
+        nextImage_++;
+        frames_++;
+        bgrValid_ = true;
+        return true;
+    }
+
+    if (fd_ < 0 || !readFrame()) {
+        return false;
+    }
+    frames_++;
+    return true;
+}
+
+bool FileSource::retrieveYUYV(cv::Mat& view) const {
+    if (format_ != Format::YUYV || frames_ == 0) {
+        return false;
+    }
+    view = raw_;
+    return true;
+}
+
+cv::Mat FileSource::retrieve() {
+    if (!bgrValid_ && frames_ > 0) {
+        cv::cvtColor(raw_, bgr_, format_ == Format::YUYV ? cv::COLOR_YUV2BGR_YUYV : cv::COLOR_YUV2BGR_NV12);
+        bgrValid_ = true;
+    }
+    return bgrValid_ ? bgr_ : cv::Mat();
+}
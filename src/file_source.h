@@ -0,0 +1,58 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "frame_source.h"
+
+// Headless frame source: raw frames from a file or pipe, or a numbered image
+// sequence. grab() reads as fast as the producer delivers, so a file runs
+// the pipeline unthrottled and a pipe is paced by whatever writes to it.
+//
+// Specs:
+//   yuyv:<W>x<H>:<path>    Packed YUYV frames ("-" reads stdin)
+//   nv12:<W>x<H>:<path>    NV12 frames
+//   images:<pattern>       one %d or %0Nd (frames/%04d.png), from 0 or 1
+class FileSource : public FrameSource {
+public:
+    FileSource() = default;
+    ~FileSource() override;
+
+    FileSource(const FileSource&) = delete;
+    FileSource& operator=(const FileSource&) = delete;
+
+    // Images are probed here, so the size is known on success
+    bool open(const std::string& spec);
+    void close();
+    bool isOpened() const { return fd_ >= 0 || !pattern_.empty(); }
+
+    // False at end of input
+    bool grab() override;
+    bool retrieveYUYV(cv::Mat& view) const override;
+    cv::Mat retrieve() override;
+    bool canDecodeYUYV(int, int) const override { return false; }
+    bool decodeYUYV(cv::Mat&) override { return false; }
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    uint64_t getFrameCount() const { return frames_; }
+
+private:
+    enum class Format { YUYV, NV12, IMAGES };
+
+    bool readFrame();
+    std::string imagePath(int index) const;
+
+    Format format_ = Format::YUYV;
+    int fd_ = -1;
+    bool ownsFd_ = false;
+    std::string pattern_;
+    int nextImage_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    uint64_t frames_ = 0;
+
+    cv::Mat raw_;                   // Last raw frame (YUYV: CV_8UC2, NV12: H*3/2 rows of CV_8UC1)
+    cv::Mat bgr_;                   // Decoded image or converted raw frame
+    bool bgrValid_ = false;
+};
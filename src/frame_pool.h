@@ -0,0 +1,32 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Reusable frame buffers for the render paths that need a BGR intermediate,
+// so steady-state frames never allocate. Slots are handed out round-robin and
+// only reallocated when the requested size or type changes; a frame stays
+// valid until getCount() more have been acquired.
+class FramePool {
+public:
+    explicit FramePool(size_t count = 2) : frames_(count > 0 ? count : 1) {}
+
+    cv::Mat& acquire(int rows, int cols, int type) {
+        cv::Mat& frame = frames_[next_];
+        next_ = (next_ + 1) % frames_.size();
+        frame.create(rows, cols, type);
+        return frame;
+    }
+
+    size_t getCount() const { return frames_.size(); }
+
+    void release() {
+        for (auto& frame : frames_) {
+            frame.release();
+        }
+    }
+
+private:
+    std::vector<cv::Mat> frames_;
+    size_t next_ = 0;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "spsc_ring.h"
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// Fixed pool of frames handed from one producer thread to one consumer
+// thread. At most `depth` frames wait in the queue; when the consumer falls
+// behind, the producer recycles the oldest waiting frame (drop-oldest), so
+// it never blocks and latency stays bounded. Frames are never copied or
+// reallocated by the ring itself: each side fills or reads a slot in place.
+template <typename T>
+class FrameRing {
+public:
+    explicit FrameRing(int depth)
+        : depth_(std::max(depth, 1)),
+          slots_(depth_ + 2),          // + one being written, + one being read
+          queued_(depth_ + 2),
+          free_(depth_ + 2) {
+        eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        reset();
+    }
+
+    ~FrameRing() {
+        if (eventFd_ >= 0) {
+            ::close(eventFd_);
+        }
+    }
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Only while neither side is running: every slot becomes free again
+    void reset() {
+        int idx;
+        while (queued_.pop(idx)) {}
+        while (free_.pop(idx)) {}
+        for (int i = 0; i < static_cast<int>(slots_.size()); ++i) {
+            free_.push(i);
+        }
+        writing_ = -1;
+        reading_ = -1;
+        drainEvents();
+    }
+
+    // Producer: the slot to fill, the same one until publish()
+    T& acquireWrite() {
+        if (writing_ < 0) {
+            int idx = -1;
+            if (queued_.size() >= static_cast<size_t>(depth_) && queued_.pop(idx)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                // A free slot always exists; this only spins while the
+                // consumer is between taking a new frame and returning its old one
+                while (!free_.pop(idx)) {
+                    std::this_thread::yield();
+                }
+            }
+            writing_ = idx;
+        }
+        return slots_[writing_];
+    }
+
+    // Producer: queue the acquired slot for the consumer
+    void publish() {
+        if (writing_ < 0) return;
+        queued_.push(writing_);   // Can't fail: capacity covers every slot
+        writing_ = -1;
+        notify();
+    }
+
+    // Wake a consumer blocked in acquireRead() (e.g. producer stopping)
+    void notify() {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t r = write(eventFd_, &one, sizeof(one));
+    }
+
+    // Consumer: next queued frame in order, waiting up to timeoutMs
+    // (nullptr on timeout). The previously returned frame goes back to the
+    // producer, so it is valid only until the next call.
+    T* acquireRead(int timeoutMs) {
+        releaseRead();
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        int idx;
+        while (!queued_.pop(idx)) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                return nullptr;
+            }
+            struct pollfd pfd{eventFd_, POLLIN, 0};
+            if (poll(&pfd, 1, static_cast<int>(remaining)) > 0) {
+                drainEvents();
+            }
+        }
+        reading_ = idx;
+        return &slots_[idx];
+    }
+
+    // Consumer: hand the current frame back early
+    void releaseRead() {
+        if (reading_ >= 0) {
+            free_.push(reading_);
+            reading_ = -1;
+        }
+    }
+
+    // Readable whenever a frame was published (for poll()-based consumers)
+    int getEventFd() const { return eventFd_; }
+    int getDepth() const { return depth_; }
+    uint64_t getDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Direct slot access for preallocation before the threads start
+    std::vector<T>& slots() { return slots_; }
+
+private:
+    void drainEvents() {
+        uint64_t count;
+        [[maybe_unused]] ssize_t r = read(eventFd_, &count, sizeof(count));
+    }
+
+    int depth_;
+    std::vector<T> slots_;
+    SpscRing<int> queued_;      // Producer -> consumer, oldest first
+    SpscRing<int> free_;        // Consumer -> producer
+    int writing_ = -1;          // Producer-owned
+    int reading_ = -1;          // Consumer-owned
+    int eventFd_ = -1;
+    std::atomic<uint64_t> dropped_{0};
+};
@@ -0,0 +1,249 @@
+#include "frame_scaler.h"
+#include "pixel_convert.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+const char* scaleFilterName(ScaleFilter filter) {
+    switch (filter) {
+        case ScaleFilter::NEAREST:  return "nearest";
+        case ScaleFilter::BILINEAR: return "bilinear";
+        case ScaleFilter::AREA:     return "area";
+    }
+    return "unknown";
+}
+
+void FrameScaler::setFilter(ScaleFilter filter) {
+    if (filter != filter_) {
+        filter_ = filter;
+        srcW_ = srcH_ = dstW_ = dstH_ = 0;  // Rebuild taps on the next frame
+    }
+}
+
+void FrameScaler::buildAxis(Axis& axis, int srcSize, int dstSize, int stride, ScaleFilter filter) {
+    const double scale = static_cast<double>(srcSize) / dstSize;
+    if (filter == ScaleFilter::AREA && scale <= 1.0) {
+        filter = ScaleFilter::BILINEAR;
+    }
+    const int taps = filter == ScaleFilter::NEAREST ? 1
+                   : filter == ScaleFilter::BILINEAR ? 2
+                   : static_cast<int>(std::ceil(scale)) + 1;
+    axis.taps = taps;
+    axis.index.assign(static_cast<size_t>(dstSize) * taps, 0);
+    axis.weight.assign(static_cast<size_t>(dstSize) * taps, 0);
+
+    for (int i = 0; i < dstSize; ++i) {
+        int* index = &axis.index[static_cast<size_t>(i) * taps];
+        uint16_t* weight = &axis.weight[static_cast<size_t>(i) * taps];
+
+        switch (filter) {
+            case ScaleFilter::NEAREST: {
+                int s = std::min(srcSize - 1, static_cast<int>((i + 0.5) * scale));
+                index[0] = s * stride;
+                weight[0] = 256;
+                break;
+            }
+
+            case ScaleFilter::BILINEAR: {
+                // Pixel centres line up, as with cv::INTER_LINEAR
+                double pos = std::clamp((i + 0.5) * scale - 0.5, 0.0, srcSize - 1.0);
+                int s = static_cast<int>(pos);
+                int f = static_cast<int>(std::lround((pos - s) * 256));
+                if (f == 256) {
+                    s++;
+                    f = 0;
+                }
+                index[0] = s * stride;
+                index[1] = std::min(s + 1, srcSize - 1) * stride;
+                weight[0] = static_cast<uint16_t>(256 - f);
+                weight[1] = static_cast<uint16_t>(f);
+                break;
+            }
+
+            case ScaleFilter::AREA: {
+                // Weight each source pixel by how much of it [begin, end) covers;
+                // rounding the running sum keeps the total at exactly 256
+                double begin = i * scale;
+                double end = begin + scale;
+                int first = static_cast<int>(begin);
+                double covered = 0.0;
+                int total = 0;
+                for (int t = 0; t < taps; ++t) {
+                    int s = first + t;
+                    covered += std::max(0.0, std::min(end, s + 1.0) - std::max(begin, static_cast<double>(s)));
+                    int sum = static_cast<int>(std::lround(covered / scale * 256));
+                    index[t] = std::min(s, srcSize - 1) * stride;
+                    weight[t] = static_cast<uint16_t>(sum - total);
+                    total = sum;
+                }
+                break;
+            }
+        }
+    }
+}
+
+void FrameScaler::prepare(int srcW, int srcH, int dstW, int dstH, bool yuyvSource) {
+    if (srcW == srcW_ && srcH == srcH_ && dstW == dstW_ && dstH == dstH_ && yuyvSource == yuyvSource_) {
+        return;
+    }
+    srcW_ = srcW;
+    srcH_ = srcH;
+    dstW_ = dstW;
+    dstH_ = dstH;
+    yuyvSource_ = yuyvSource;
+    if (yuyvSource) {
+        // Luma every 2 bytes; U and V once per pixel pair, every 4 bytes
+        buildAxis(xAxis_, srcW, dstW, 2, filter_);
+        buildAxis(chromaAxis_, srcW / 2, dstW / 2, 4, filter_);
+    } else {
+        buildAxis(xAxis_, srcW, dstW, 3, filter_);
+    }
+    buildAxis(yAxis_, srcH, dstH, 1, filter_);
+
+    size_t bands = (dstH + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    columnScratch_.assign(bands * srcW * (yuyvSource ? 2 : 3), 0);
+    rowScratch_.assign(yuyvSource ? 0 : bands * dstW * 3, 0);
+}
+
+// Horizontal taps over one source row. Input values are scaled by
+// 2^(SHIFT - 8), so 8-bit rows use SHIFT 8 and vertically filtered ones 16.
+template <typename T, int SHIFT>
+static void filterRow(const T* in, uint8_t* out, const int* index, const uint16_t* weight,
+                      int taps, int width) {
+    constexpr uint32_t ROUND = 1u << (SHIFT - 1);
+    for (int x = 0; x < width; ++x, index += taps, weight += taps) {
+        uint32_t b = ROUND, g = ROUND, r = ROUND;
+        for (int t = 0; t < taps; ++t) {
+            const T* p = in + index[t];
+            uint32_t w = weight[t];
+            b += p[0] * w;
+            g += p[1] * w;
+            r += p[2] * w;
+        }
+        out[x * 3] = static_cast<uint8_t>(b >> SHIFT);
+        out[x * 3 + 1] = static_cast<uint8_t>(g >> SHIFT);
+        out[x * 3 + 2] = static_cast<uint8_t>(r >> SHIFT);
+    }
+}
+
+// The YUYV equivalent: luma taps per output pixel, then U and V taps per
+// output pixel pair
+template <typename T, int SHIFT>
+static void filterRowYUYV(const T* in, uint8_t* out, const int* yIndex, const uint16_t* yWeight, int yTaps,
+                          const int* cIndex, const uint16_t* cWeight, int cTaps, int width) {
+    constexpr uint32_t ROUND = 1u << (SHIFT - 1);
+    for (int x = 0; x < width; ++x, yIndex += yTaps, yWeight += yTaps) {
+        uint32_t luma = ROUND;
+        for (int t = 0; t < yTaps; ++t) {
+            luma += in[yIndex[t]] * static_cast<uint32_t>(yWeight[t]);
+        }
+        out[x * 2] = static_cast<uint8_t>(luma >> SHIFT);
+    }
+    for (int x = 0; x < width / 2; ++x, cIndex += cTaps, cWeight += cTaps) {
+        uint32_t u = ROUND, v = ROUND;
+        for (int t = 0; t < cTaps; ++t) {
+            const T* p = in + cIndex[t];
+            uint32_t w = cWeight[t];
+            u += p[1] * w;
+            v += p[3] * w;
+        }
+        out[x * 4 + 1] = static_cast<uint8_t>(u >> SHIFT);
+        out[x * 4 + 3] = static_cast<uint8_t>(v >> SHIFT);
+    }
+}
+
+template <typename T, int SHIFT>
+void FrameScaler::filterRowAs(const T* in, uint8_t* out) const {
+    if (yuyvSource_) {
+        filterRowYUYV<T, SHIFT>(in, out, xAxis_.index.data(), xAxis_.weight.data(), xAxis_.taps,
+                                chromaAxis_.index.data(), chromaAxis_.weight.data(), chromaAxis_.taps, dstW_);
+    } else {
+        filterRow<T, SHIFT>(in, out, xAxis_.index.data(), xAxis_.weight.data(), xAxis_.taps, dstW_);
+    }
+}
+
+void FrameScaler::scaleRow(const cv::Mat& src, int y, uint16_t* column, uint8_t* out) const {
+    const int taps = yAxis_.taps;
+    const int* rows = &yAxis_.index[static_cast<size_t>(y) * taps];
+    const uint16_t* weights = &yAxis_.weight[static_cast<size_t>(y) * taps];
+
+    // A single source row needs no vertical pass
+    if (weights[0] == 256) {
+        filterRowAs<uint8_t, 8>(src.ptr(rows[0]), out);
+        return;
+    }
+
+    // Sum of 8-bit values times weights totalling 256 fits in 16 bits;
+    // plain loops over contiguous rows, so the compiler vectorizes them
+    const int n = srcW_ * (yuyvSource_ ? 2 : 3);
+    const uint8_t* first = src.ptr(rows[0]);
+    const uint16_t w0 = weights[0];
+    for (int i = 0; i < n; ++i) {
+        column[i] = static_cast<uint16_t>(first[i] * w0);
+    }
+    for (int t = 1; t < taps; ++t) {
+        const uint16_t w = weights[t];
+        if (w == 0) continue;
+        const uint8_t* row = src.ptr(rows[t]);
+        for (int i = 0; i < n; ++i) {
+            column[i] = static_cast<uint16_t>(column[i] + row[i] * w);
+        }
+    }
+    filterRowAs<uint16_t, 16>(column, out);
+}
+
+void FrameScaler::scale(const cv::Mat& src, cv::Mat& dst, bool yuyv) {
+    const bool yuyvSource = src.type() == CV_8UC2;
+    prepare(src.cols, src.rows, dst.cols, dst.rows, yuyvSource);
+
+    // YUYV sources come out as YUYV rows; BGR ones are converted after scaling
+    const bool convert = yuyv && !yuyvSource;
+    const int channels = yuyvSource ? 2 : 3;
+    auto band = [&](int b) {
+        uint16_t* column = columnScratch_.data() + static_cast<size_t>(b) * srcW_ * channels;
+        uint8_t* row = convert ? rowScratch_.data() + static_cast<size_t>(b) * dstW_ * 3 : nullptr;
+        const int end = std::min(dstH_, (b + 1) * ROWS_PER_TASK);
+        for (int y = b * ROWS_PER_TASK; y < end; ++y) {
+            if (convert) {
+                scaleRow(src, y, column, row);
+                bgrRowToYUYV(row, dst.ptr(y), dstW_);
+            } else {
+                scaleRow(src, y, column, dst.ptr(y));
+            }
+        }
+    };
+
+    const int bands = (dstH_ + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    if (parallel_) {
+        ThreadPool::shared().parallelFor(bands, band);
+    } else {
+        for (int b = 0; b < bands; ++b) band(b);
+    }
+}
+
+void FrameScaler::toYUYV(const cv::Mat& src, cv::Mat& dst) {
+    if (src.empty() || dst.empty()) {
+        return;
+    }
+    if (src.cols == dst.cols && src.rows == dst.rows) {
+        if (src.type() == CV_8UC2) {
+            src.copyTo(dst);
+        } else {
+            cv::cvtColor(src, dst, cv::COLOR_BGR2YUV_YUYV);
+        }
+        return;
+    }
+    scale(src, dst, true);
+}
+
+void FrameScaler::toBGR(const cv::Mat& src, cv::Mat& dst, int width, int height) {
+    if (src.empty()) {
+        return;
+    }
+    dst.create(height, width, CV_8UC3);
+    if (src.cols == width && src.rows == height) {
+        src.copyTo(dst);
+        return;
+    }
+    scale(src, dst, false);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+#include "config.h"
+
+const char* scaleFilterName(ScaleFilter filter);
+
+// Resamples a BGR frame to another size and converts it in the same pass, so
+// there is no full-size intermediate: each output row is filtered vertically
+// into a 16-bit row, then horizontally into a BGR row that is converted while
+// still in cache. YUYV frames are resampled as YUYV, luma and chroma each on
+// their own grid. Row bands run on the shared thread pool. Taps are only
+// rebuilt when the sizes, source format or filter change, so steady-state
+// frames allocate nothing.
+class FrameScaler {
+public:
+    void setFilter(ScaleFilter filter);
+    ScaleFilter getFilter() const { return filter_; }
+
+    // Row bands on the shared pool (default), or all on the calling thread
+    // when the caller already runs scalers in parallel
+    void setParallel(bool parallel) { parallel_ = parallel; }
+
+    // BGR or YUYV frame of any size into dst, a YUYV (CV_8UC2) frame of fixed size
+    void toYUYV(const cv::Mat& src, cv::Mat& dst);
+
+    // BGR frame of any size into a width x height BGR dst (reallocated only
+    // if its size or type doesn't match)
+    void toBGR(const cv::Mat& src, cv::Mat& dst, int width, int height);
+
+private:
+    static constexpr int ROWS_PER_TASK = 32;
+
+    // Fixed-point filter along one axis: output i reads the source offsets
+    // index[i * taps + t] with weights summing to 256
+    struct Axis {
+        int taps = 0;
+        std::vector<int> index;
+        std::vector<uint16_t> weight;
+    };
+
+    static void buildAxis(Axis& axis, int srcSize, int dstSize, int stride, ScaleFilter filter);
+    void prepare(int srcW, int srcH, int dstW, int dstH, bool yuyvSource);
+    void scale(const cv::Mat& src, cv::Mat& dst, bool yuyv);
+    void scaleRow(const cv::Mat& src, int y, uint16_t* column, uint8_t* out) const;
+    template <typename T, int SHIFT> void filterRowAs(const T* in, uint8_t* out) const;
+
+    ScaleFilter filter_ = ScaleFilter::BILINEAR;
+    bool parallel_ = true;
+    bool yuyvSource_ = false;
+    int srcW_ = 0;
+    int srcH_ = 0;
+    int dstW_ = 0;
+    int dstH_ = 0;
+    Axis xAxis_;                        // Offsets in bytes within a BGR row, or of YUYV luma
+    Axis chromaAxis_;                   // Offsets in bytes of YUYV pixel pairs (YUYV sources only)
+    Axis yAxis_;                        // Source row numbers
+    std::vector<uint16_t> columnScratch_;   // Per band: one vertically filtered source row
+    std::vector<uint8_t> rowScratch_;       // Per band: one BGR output row
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <cerrno>
+#include <cmath>
+#include <algorithm>
+#include <time.h>
+
+// Paces the main loop. Without a camera, frames go out on absolute
+// CLOCK_MONOTONIC deadlines (clock_nanosleep TIMER_ABSTIME), so work time
+// never adds to the period and the cadence doesn't drift. With a camera the
+// blocking grab paces the loop and frames are only recorded here.
+class FrameScheduler {
+public:
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t missed = 0;        // Deadlines already past, or camera frames > 1.5 periods apart
+        double jitterMs = 0.0;      // RMS deviation of the frame interval from the period
+        double maxJitterMs = 0.0;
+    };
+
+    void setFrameRate(double fps) {
+        if (fps > 0) {
+            periodNs_ = static_cast<int64_t>(1e9 / fps);
+        }
+    }
+
+    // Sleep until the next deadline. If it has already passed the frame
+    // counts as missed and the schedule restarts from now rather than
+    // bursting to catch up.
+    void waitForDeadline() {
+        int64_t now = nowNs();
+        deadline_ = (deadline_ == 0) ? now + periodNs_ : deadline_ + periodNs_;
+
+        if (deadline_ <= now) {
+            ++missed_;
+            deadline_ = now;
+        } else {
+            struct timespec ts;
+            ts.tv_sec = deadline_ / 1000000000;
+            ts.tv_nsec = deadline_ % 1000000000;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+        }
+        record(nowNs(), false);
+    }
+
+    // A frame paced by something else (the camera) just went out
+    void frameDelivered() {
+        int64_t now = nowNs();
+        record(now, true);
+        deadline_ = now;  // Timed pacing resumes one period after this frame
+    }
+
+    // Drop the schedule after a pause (idle), so the next frame neither
+    // counts as missed nor as a long interval
+    void restart() {
+        deadline_ = 0;
+        last_ = 0;
+    }
+
+    Stats getStats() const {
+        Stats s;
+        s.frames = frames_;
+        s.missed = missed_;
+        if (intervals_ > 0) {
+            s.jitterMs = std::sqrt(sumSquaredErrorNs_ / intervals_) / 1e6;
+        }
+        s.maxJitterMs = maxErrorNs_ / 1e6;
+        return s;
+    }
+
+    void resetStats() {
+        frames_ = missed_ = intervals_ = 0;
+        sumSquaredErrorNs_ = 0.0;
+        maxErrorNs_ = 0.0;
+    }
+
+private:
+    static int64_t nowNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    void record(int64_t now, bool external) {
+        ++frames_;
+        if (last_ != 0) {
+            int64_t interval = now - last_;
+            if (external && interval > periodNs_ * 3 / 2) {
+                ++missed_;
+            }
+            // Long gaps are state changes (camera opening), not jitter
+            if (interval < periodNs_ * 4) {
+                double error = static_cast<double>(interval - periodNs_);
+                sumSquaredErrorNs_ += error * error;
+                maxErrorNs_ = std::max(maxErrorNs_, std::fabs(error));
+                ++intervals_;
+            }
+        }
+        last_ = now;
+    }
+
+    int64_t periodNs_ = 1000000000 / 30;
+    int64_t deadline_ = 0;
+    int64_t last_ = 0;
+
+    uint64_t frames_ = 0;
+    uint64_t missed_ = 0;
+    uint64_t intervals_ = 0;
+    double sumSquaredErrorNs_ = 0.0;
+    double maxErrorNs_ = 0.0;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "frame_scaler.h"
+
+// Where the main loop sends finished frames: the virtual camera itself, or
+// the output thread writing to it. Frames are YUYV at getWidth() x getHeight().
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+
+    virtual int getWidth() const = 0;
+    virtual int getHeight() const = 0;
+
+    // BGR at any size (scaled and converted), or YUYV at the sink size
+    virtual void writeFrame(const cv::Mat& frame) = 0;
+    virtual void writeFrameYUYV(const cv::Mat& yuyv) = 0;
+
+    // Render straight into the next frame (CV_8UC2, stale contents), then send it
+    virtual cv::Mat& acquireBuffer() = 0;
+    virtual void commitBuffer() = 0;
+
+    // Resampling used by writeFrame() when the frame size differs
+    virtual void setScaleFilter(ScaleFilter filter) { scaler_.setFilter(filter); }
+
+protected:
+    FrameScaler scaler_;            // BGR at any size to YUYV at the sink size, in one pass
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+// Where the main loop gets camera frames: the camera itself, or the capture
+// thread decoding ahead of it. grab() waits for the next frame; the retrieve
+// calls then read it and stay valid until the next grab().
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    virtual bool grab() = 0;
+
+    // Header over a YUYV frame, no copy. False if the frame isn't YUYV.
+    virtual bool retrieveYUYV(cv::Mat& view) const = 0;
+
+    // BGR frame (decoded or converted on demand)
+    virtual cv::Mat retrieve() = 0;
+
+    // Compressed frames that can be decoded straight to YUYV at dstW x dstH
+    virtual bool canDecodeYUYV(int dstW, int dstH) const = 0;
+    virtual bool decodeYUYV(cv::Mat& dst) = 0;
+};
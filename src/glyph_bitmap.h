@@ -0,0 +1,10 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+// Pre-rasterized glyph, copied out of FreeType's glyph slot
+struct GlyphBitmap {
+    cv::Mat alpha;                   // 8-bit coverage mask (empty if glyph missing)
+    int left = 0;                    // Horizontal bearing (FreeType bitmap_left)
+    int top = 0;                     // Vertical bearing (FreeType bitmap_top)
+};
@@ -3,18 +3,44 @@
 #include "virtual_output.h"
 #include "static_effect.h"
 #include "matrix_effect.h"
+#include "effect_registry.h"
 #include "time_utils.h"
-#include "consumer_detector.h"
+#include "consumer_monitor.h"
+#include "blend.h"
+#include "capture_thread.h"
+#include "output_thread.h"
+#include "frame_scheduler.h"
+#include "frame_pool.h"
+#include "alloc_counter.h"
+#include "stage_stats.h"
+#include "stats_server.h"
+#include "file_source.h"
+#include "file_sink.h"
+#include "shm_sink.h"
+#include "fan_out_sink.h"
+#include "device_manager.h"
+#include "thread_placement.h"
 
 #include <iostream>
 #include <chrono>
 #include <random>
 #include <csignal>
 #include <cstring>
+#include <cstdio>
 #include <getopt.h>
 
 static volatile bool running = true;
 
+// What the current iteration produces for the virtual camera
+enum class FrameKind {
+    BGR,        // outputFrame holds a BGR image (passthrough / overlay)
+    YUYV,       // outputFrame is the camera's raw YUYV buffer at the output size
+    MJPEG,      // Camera's MJPEG frame, decoded at write time into the output buffer
+    STATIC,     // Idle static, rendered at write time
+    IDLE,       // No consumers: one prepared static frame, repeated at the idle rate
+    EFFECT      // Current effect sequence step, rendered at write time (over outputFrame if set)
+};
+
 void signalHandler(int) {
     running = false;
 }
@@ -25,8 +51,13 @@ void printUsage(const char* progName) {
               << "Time values accept units: ms, s, m, h (e.g., 500ms, 5s, 2m, 1h)\n\n"
               << "Options:\n"
               << "  -d, --device <path>        Input camera device (default: auto-detect)\n"
-              << "  -o, --output <path>        Virtual camera device (default: /dev/video2)\n"
+              << "  -o, --output <list>        Virtual camera device(s) as path[:<W>x<H>],...; one\n"
+              << "                             capture and render feeds them all (default: /dev/video2)\n"
               << "  -r, --res <level>          Resolution: high, medium, low (default: high)\n"
+              << "  --input <spec>             Read frames instead of a camera: yuyv:<W>x<H>:<path>,\n"
+              << "                             nv12:<W>x<H>:<path> or images:<pattern> (path - = stdin)\n"
+              << "  --sink <spec>              Output: v4l2 (default), file:<path> (raw YUYV, - = stdout)\n"
+              << "                             or shm:<name> (shared-memory ring)\n"
               << "  --min-interval <time>      Minimum interval between effects (default: 1m)\n"
               << "  --max-interval <time>      Maximum interval between effects (default: 60m)\n"
               << "  --effect-duration <time>   Matrix effect duration (default: 5s)\n"
@@ -35,7 +66,36 @@ void printUsage(const char* progName) {
               << "  -c, --cycles <count>       Number of effect cycles, 0=infinite (default: 0)\n"
               << "  -t, --test                 Trigger effect immediately (same as --start-delay 0)\n"
               << "  --no-on-demand             Keep camera open always (don't wait for consumers)\n"
+              << "  --idle-interval <time>     Frame interval while no consumer is attached (default: 1s)\n"
+              << "  --camera-linger <time>     Keep the camera open this long after the last consumer\n"
+              << "                             leaves, for instant reconnects (default: 0)\n"
               << "  --overlay                  Overlay matrix effect on camera feed (90% opacity)\n"
+              << "  --theme <name>             Matrix colours: green, amber, cyan, red, white\n"
+              << "                             (default: green)\n"
+              << "  --output-buffers <n>       Virtual camera mmap buffers, 0=use write() (default: 3)\n"
+              << "  --capture-backend <name>   Camera backend: v4l2, opencv (default: v4l2)\n"
+              << "  --capture-buffers <n>      Camera buffer ring size, fewer=less latency (default: 3)\n"
+              << "  --mjpeg-decoder <name>     MJPEG decoder: auto, libjpeg, opencv (default: auto)\n"
+              << "  --pipeline-depth <n>       Frames queued between capture/render/output threads,\n"
+              << "                             0=single-threaded (default: 2)\n"
+              << "  --capture-cpus <list>      Pin the capture thread to CPUs, e.g. 2 or 0-3,6\n"
+              << "  --render-cpus <list>       Pin the render loop and its worker threads to CPUs\n"
+              << "  --output-cpus <list>       Pin the output thread to CPUs\n"
+              << "  --realtime <policy>[:<n>]  Real-time scheduling for the pipeline threads: fifo\n"
+              << "                             or rr, priority 1-99 (default priority: 10)\n"
+              << "  --mlock                    Lock memory so frame buffers are never paged out\n"
+              << "  --static-mode <name>       Static frames: cached, procedural (default: cached)\n"
+              << "  --effects <list>           Effect sequence as name[:time],... (default: static,matrix;\n"
+              << "                             time defaults to --static-duration for static,\n"
+              << "                             --effect-duration otherwise)\n"
+              << "  --scale-filter <name>      Camera to output resampling: nearest, bilinear, area\n"
+              << "                             (default: bilinear)\n"
+              << "  --render-threads <n>       Threads drawing the matrix effect, 0=one per core\n"
+              << "                             (default: 0)\n"
+              << "  --seed <n>                 Seed effect randomness for reproducible frames,\n"
+              << "                             0=random (default: 0)\n"
+              << "  --stats-interval <time>    Print per-stage latency and frame stats this often\n"
+              << "  --stats-socket <path>      Serve stats as Prometheus text on a Unix socket\n"
               << "  -h, --help                 Show this help\n\n"
               << "On-demand mode (default):\n"
               << "  The physical camera is only opened when an application connects to the\n"
@@ -48,6 +108,40 @@ void printUsage(const char* progName) {
               << "  " << progName << " --no-on-demand  # Always keep camera open\n";
 }
 
+// "/dev/video2,/dev/video3:640x480"; exits on a malformed size
+static std::vector<OutputTarget> parseOutputList(const std::string& list) {
+    std::vector<OutputTarget> targets;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string entry = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (entry.empty()) continue;
+
+        // Stable paths (/dev/v4l/by-path/...) contain colons too, so only a
+        // trailing <W>x<H> counts as a size
+        OutputTarget target;
+        target.device = entry;
+        size_t colon = entry.rfind(':');
+        if (colon != std::string::npos) {
+            int w, h;
+            char trailing;
+            if (sscanf(entry.c_str() + colon + 1, "%dx%d%c", &w, &h, &trailing) == 2) {
+                if (w <= 0 || h <= 0) {
+                    std::cerr << "Invalid output size: " << entry << " (use path:<W>x<H>)\n";
+                    exit(1);
+                }
+                target.device = entry.substr(0, colon);
+                target.width = w;
+                target.height = h;
+            }
+        }
+        targets.push_back(target);
+    }
+    return targets;
+}
+
 Config parseArgs(int argc, char* argv[]) {
     Config config;
 
@@ -63,7 +157,29 @@ Config parseArgs(int argc, char* argv[]) {
         {"cycles",          required_argument, nullptr, 'c'},
         {"test",            no_argument,       nullptr, 't'},
         {"no-on-demand",    no_argument,       nullptr, 'O'},
+        {"idle-interval",   required_argument, nullptr, 'W'},
+        {"camera-linger",   required_argument, nullptr, 'G'},
         {"overlay",         no_argument,       nullptr, 'Y'},
+        {"theme",           required_argument, nullptr, 'C'},
+        {"output-buffers",  required_argument, nullptr, 'B'},
+        {"capture-backend", required_argument, nullptr, 'A'},
+        {"capture-buffers", required_argument, nullptr, 'N'},
+        {"mjpeg-decoder",   required_argument, nullptr, 'J'},
+        {"pipeline-depth",  required_argument, nullptr, 'P'},
+        {"capture-cpus",    required_argument, nullptr, 'a'},
+        {"render-cpus",     required_argument, nullptr, 'n'},
+        {"output-cpus",     required_argument, nullptr, 'u'},
+        {"realtime",        required_argument, nullptr, 'X'},
+        {"mlock",           no_argument,       nullptr, 'L'},
+        {"static-mode",     required_argument, nullptr, 'S'},
+        {"effects",         required_argument, nullptr, 'E'},
+        {"scale-filter",    required_argument, nullptr, 'F'},
+        {"render-threads",  required_argument, nullptr, 'T'},
+        {"seed",            required_argument, nullptr, 'R'},
+        {"stats-interval",  required_argument, nullptr, 'I'},
+        {"stats-socket",    required_argument, nullptr, 'K'},
+        {"input",           required_argument, nullptr, 'i'},
+        {"sink",            required_argument, nullptr, 'k'},
         {"help",            no_argument,       nullptr, 'h'},
         {nullptr,           0,                 nullptr, 0}
     };
@@ -71,6 +187,7 @@ Config parseArgs(int argc, char* argv[]) {
     int opt;
     int optionIndex = 0;
     bool startDelaySet = false;
+    std::string effectList = "static,matrix";
 
     while ((opt = getopt_long(argc, argv, "d:o:r:c:th", longOptions, &optionIndex)) != -1) {
         try {
@@ -79,7 +196,18 @@ Config parseArgs(int argc, char* argv[]) {
                     config.inputDevice = optarg;
                     break;
                 case 'o':
-                    config.outputDevice = optarg;
+                    config.outputs = parseOutputList(optarg);
+                    break;
+                case 'i':
+                    config.inputSpec = optarg;
+                    break;
+                case 'k':
+                    config.sinkSpec = optarg;
+                    if (config.sinkSpec != "v4l2" && config.sinkSpec.rfind("file:", 0) != 0 &&
+                        config.sinkSpec.rfind("shm:", 0) != 0) {
+                        std::cerr << "Invalid sink: " << config.sinkSpec << " (use v4l2, file:<path> or shm:<name>)\n";
+                        exit(1);
+                    }
                     break;
                 case 'r': {
                     std::string res = optarg;
@@ -122,9 +250,143 @@ Config parseArgs(int argc, char* argv[]) {
                 case 'O':
                     config.onDemand = false;
                     break;
+                case 'W':
+                    config.idleInterval = parseTime(optarg);
+                    break;
+                case 'G':
+                    config.cameraLinger = parseTime(optarg);
+                    break;
                 case 'Y':
                     config.overlay = true;
                     break;
+                case 'B':
+                    config.outputBuffers = std::stoi(optarg);
+                    break;
+                case 'A': {
+                    std::string backend = optarg;
+                    if (backend == "v4l2" || backend == "V4L2") {
+                        config.captureBackend = CaptureBackend::V4L2;
+                    } else if (backend == "opencv" || backend == "OPENCV") {
+                        config.captureBackend = CaptureBackend::OPENCV;
+                    } else {
+                        std::cerr << "Invalid capture backend: " << backend << " (use v4l2 or opencv)\n";
+                        exit(1);
+                    }
+                    break;
+                }
+                case 'N':
+                    config.captureBuffers = std::stoi(optarg);
+                    break;
+                case 'P':
+                    config.pipelineDepth = std::stoi(optarg);
+                    break;
+                case 'J': {
+                    std::string decoder = optarg;
+                    if (decoder == "auto") {
+                        config.mjpegDecoder = MjpegDecoderType::AUTO;
+                    } else if (decoder == "libjpeg") {
+                        config.mjpegDecoder = MjpegDecoderType::LIBJPEG;
+                    } else if (decoder == "opencv") {
+                        config.mjpegDecoder = MjpegDecoderType::OPENCV;
+                    } else {
+                        std::cerr << "Invalid MJPEG decoder: " << decoder << " (use auto, libjpeg or opencv)\n";
+                        exit(1);
+                    }
+                    break;
+                }
+                case 'S': {
+                    std::string mode = optarg;
+                    if (mode == "cached") {
+                        config.staticMode = StaticMode::CACHED;
+                    } else if (mode == "procedural") {
+                        config.staticMode = StaticMode::PROCEDURAL;
+                    } else {
+                        std::cerr << "Invalid static mode: " << mode << " (use cached or procedural)\n";
+                        exit(1);
+                    }
+                    break;
+                }
+                case 'a':
+                case 'n':
+                case 'u': {
+                    std::vector<int>& cpus = opt == 'a' ? config.captureCpus
+                                           : opt == 'n' ? config.renderCpus : config.outputCpus;
+                    if (!parseCpuList(optarg, cpus)) {
+                        std::cerr << "Invalid CPU list: " << optarg << " (use e.g. 2, 0-3 or 0,2,4-5)\n";
+                        exit(1);
+                    }
+                    break;
+                }
+                case 'X': {
+                    std::string spec = optarg;
+                    std::string policy = spec.substr(0, spec.find(':'));
+                    if (policy == "fifo") {
+                        config.realtimePolicy = RealtimePolicy::FIFO;
+                    } else if (policy == "rr") {
+                        config.realtimePolicy = RealtimePolicy::RR;
+                    } else {
+                        std::cerr << "Invalid real-time policy: " << policy << " (use fifo or rr)\n";
+                        exit(1);
+                    }
+                    if (policy.size() < spec.size()) {
+                        config.realtimePriority = std::stoi(spec.substr(policy.size() + 1));
+                    }
+                    if (config.realtimePriority < 1 || config.realtimePriority > 99) {
+                        std::cerr << "Invalid real-time priority: " << config.realtimePriority << " (use 1-99)\n";
+                        exit(1);
+                    }
+                    break;
+                }
+                case 'L':
+                    config.lockMemory = true;
+                    break;
+                case 'E':
+                    effectList = optarg;
+                    break;
+                case 'C': {
+                    std::string theme = optarg;
+                    if (theme == "green") {
+                        config.colorTheme = ColorTheme::GREEN;
+                    } else if (theme == "amber") {
+                        config.colorTheme = ColorTheme::AMBER;
+                    } else if (theme == "cyan") {
+                        config.colorTheme = ColorTheme::CYAN;
+                    } else if (theme == "red") {
+                        config.colorTheme = ColorTheme::RED;
+                    } else if (theme == "white") {
+                        config.colorTheme = ColorTheme::WHITE;
+                    } else {
+                        std::cerr << "Invalid theme: " << theme << " (use green, amber, cyan, red or white)\n";
+                        exit(1);
+                    }
+                    break;
+                }
+                case 'F': {
+                    std::string filter = optarg;
+                    if (filter == "nearest") {
+                        config.scaleFilter = ScaleFilter::NEAREST;
+                    } else if (filter == "bilinear") {
+                        config.scaleFilter = ScaleFilter::BILINEAR;
+                    } else if (filter == "area") {
+                        config.scaleFilter = ScaleFilter::AREA;
+                    } else {
+                        std::cerr << "Invalid scale filter: " << filter << " (use nearest, bilinear or area)\n";
+                        exit(1);
+                    }
+                    break;
+                }
+                case 'T':
+                    config.renderThreads = std::stoi(optarg);
+                    break;
+                case 'R':
+                    config.seed = static_cast<uint32_t>(std::stoul(optarg));
+                    break;
+                case 'I':
+                    config.statsInterval = parseTime(optarg);
+                    break;
+                case 'K':
+                    config.statsSocket = optarg;
+                    break;
                 case 'h':
                     printUsage(argv[0]);
                     exit(0);
@@ -143,6 +405,57 @@ Config parseArgs(int argc, char* argv[]) {
     if (config.maxInterval < config.minInterval) config.maxInterval = config.minInterval;
     if (config.effectDuration < 10) config.effectDuration = 10;
     if (config.staticDuration < 10) config.staticDuration = 10;
+    if (config.idleInterval < 10) config.idleInterval = 10;
+    if (config.outputBuffers < 0) config.outputBuffers = 0;
+    if (config.captureBuffers < 2) config.captureBuffers = 2;
+    if (config.pipelineDepth < 0) config.pipelineDepth = 0;
+    if (config.renderThreads < 0) config.renderThreads = 0;
+
+    if (config.outputs.empty()) {
+        config.outputs.push_back({config.outputDevice});
+    }
+    config.outputDevice = config.outputs[0].device;
+
+    // Consumers can only be tracked on a virtual camera, and a headless
+    // source has no device to release
+    if (config.sinkSpec != "v4l2" || !config.inputSpec.empty()) config.onDemand = false;
+
+    // Effect sequence; durations fall back to the duration options, which
+    // may come after --effects on the command line
+    const EffectRegistry& registry = EffectRegistry::instance();
+    size_t pos = 0;
+    while (pos <= effectList.size()) {
+        size_t end = effectList.find(',', pos);
+        if (end == std::string::npos) end = effectList.size();
+        std::string entry = effectList.substr(pos, end - pos);
+        pos = end + 1;
+        if (entry.empty()) continue;
+
+        EffectStep step;
+        size_t colon = entry.find(':');
+        step.name = entry.substr(0, colon);
+        if (!registry.has(step.name)) {
+            std::cerr << "Unknown effect: " << step.name << " (available:";
+            for (const auto& name : registry.getNames()) {
+                std::cerr << " " << name;
+            }
+            std::cerr << ")\n";
+            exit(1);
+        }
+        try {
+            step.duration = colon != std::string::npos ? parseTime(entry.substr(colon + 1))
+                          : step.name == "static" ? config.staticDuration : config.effectDuration;
+        } catch (const std::exception& e) {
+            std::cerr << "Error parsing argument: " << e.what() << "\n";
+            exit(1);
+        }
+        if (step.duration < 10) step.duration = 10;
+        config.effectSequence.push_back(step);
+    }
+    if (config.effectSequence.empty()) {
+        std::cerr << "Effect sequence is empty\n";
+        exit(1);
+    }
 
     // If start delay wasn't explicitly set, mark it for random interval
     if (!startDelaySet) {
@@ -163,39 +476,118 @@ uint64_t randomIntervalMs(uint64_t minMs, uint64_t maxMs, std::mt19937& rng) {
 }
 
 // Try to detect and open a camera, returns true on success
-bool tryOpenCamera(CameraCapture& camera, const Config& config, int& width, int& height) {
-    bool success = false;
-
-    if (config.inputDevice.empty()) {
-        success = camera.detectCamera(config.resolution);
-    } else {
-        success = camera.open(config.inputDevice, config.resolution);
-    }
-
-    if (success) {
-        camera.getResolution(width, height);
+bool tryOpenCamera(DeviceManager& devices, CameraCapture& camera, const Config& config, int& width, int& height) {
+    if (!devices.openCamera(camera, config.inputDevice, config.resolution)) {
+        return false;
     }
-
-    return success;
+    camera.getResolution(width, height);
+    return true;
 }
 
 int main(int argc, char* argv[]) {
     // Set up signal handling
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+    installAllocCounter();
 
     Config config = parseArgs(argc, argv);
 
+    // Frames go to stdout: keep messages out of the stream
+    if (config.sinkSpec == "file:-") {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+    // A pipe reader going away is an error from write(), not a signal
+    if (config.sinkSpec != "v4l2") {
+        signal(SIGPIPE, SIG_IGN);
+    }
+
     std::cout << "Matrix Filter starting...\n";
     std::cout << "  Resolution preference: "
               << (config.resolution == Resolution::HIGH ? "high" :
                   config.resolution == Resolution::MEDIUM ? "medium" : "low") << "\n";
+    std::cout << "  Input: " << (config.inputSpec.empty() ? "camera" : config.inputSpec) << "\n";
+    std::cout << "  Output:";
+    if (config.sinkSpec == "v4l2") {
+        for (const auto& target : config.outputs) {
+            std::cout << " " << target.device;
+            if (target.width) std::cout << " (" << target.width << "x" << target.height << ")";
+        }
+    } else {
+        std::cout << " " << config.sinkSpec;
+    }
+    std::cout << "\n";
     std::cout << "  Min interval: " << formatTime(config.minInterval) << "\n";
     std::cout << "  Max interval: " << formatTime(config.maxInterval) << "\n";
     std::cout << "  Effect duration: " << formatTime(config.effectDuration) << "\n";
     std::cout << "  Static duration: " << formatTime(config.staticDuration) << "\n";
     std::cout << "  On-demand mode: " << (config.onDemand ? "enabled" : "disabled") << "\n";
     std::cout << "  Overlay mode: " << (config.overlay ? "enabled" : "disabled") << "\n";
+    std::cout << "  Capture backend: "
+              << (config.captureBackend == CaptureBackend::V4L2 ? "v4l2" : "opencv")
+              << " (" << config.captureBuffers << " buffers)\n";
+    std::cout << "  Pipeline: ";
+    if (config.pipelineDepth > 0) {
+        std::cout << "threaded (depth " << config.pipelineDepth << ")\n";
+    } else {
+        std::cout << "single-threaded\n";
+    }
+    std::cout << "  Effect sequence:";
+    for (size_t i = 0; i < config.effectSequence.size(); ++i) {
+        std::cout << (i ? ", " : " ") << config.effectSequence[i].name << " "
+                  << formatTime(config.effectSequence[i].duration);
+    }
+    std::cout << "\n";
+    std::cout << "  Static mode: "
+              << (config.staticMode == StaticMode::CACHED ? "cached" : "procedural") << "\n";
+    std::cout << "  Scale filter: " << scaleFilterName(config.scaleFilter) << "\n";
+    std::cout << "  Theme: " << colorThemeName(config.colorTheme) << "\n";
+    std::cout << "  Render threads: ";
+    if (config.renderThreads == 0) {
+        std::cout << "one per core\n";
+    } else {
+        std::cout << config.renderThreads << "\n";
+    }
+    if (config.statsInterval > 0 || !config.statsSocket.empty()) {
+        std::cout << "  Stats:";
+        if (config.statsInterval > 0) std::cout << " every " << formatTime(config.statsInterval);
+        if (!config.statsSocket.empty()) std::cout << " on " << config.statsSocket;
+        std::cout << "\n";
+    }
+    std::cout << "  Blend kernel: " << blendKernelName() << "\n";
+
+    // Place this (render) thread before anything is allocated or started:
+    // effect buffers are then first touched on its NUMA node, and worker
+    // pools inherit its CPUs and policy. Threads without CPUs of their own
+    // get back the full set the process started with; monitor and server
+    // threads also run at normal priority.
+    const std::vector<int> allowedCpus = getAllowedCpus();
+    auto placementFor = [&](const std::vector<int>& cpus, const char* name) {
+        ThreadPlacement placement;
+        placement.cpus = cpus.empty() ? allowedCpus : restrictCpus(cpus, allowedCpus);
+        if (placement.cpus.empty()) {
+            std::cerr << "Warning: no " << name << " CPU is available to this process, leaving it unpinned\n";
+            placement.cpus = allowedCpus;
+        }
+        placement.policy = config.realtimePolicy;
+        placement.priority = config.realtimePriority;
+        return placement;
+    };
+    const ThreadPlacement capturePlacement = placementFor(config.captureCpus, "capture");
+    const ThreadPlacement renderPlacement = placementFor(config.renderCpus, "render");
+    const ThreadPlacement outputPlacement = placementFor(config.outputCpus, "output");
+    ThreadPlacement backgroundPlacement;
+    backgroundPlacement.cpus = allowedCpus;
+    setBackgroundPlacement(backgroundPlacement);
+    applyPlacement("render", renderPlacement);
+    const bool memoryLocked = config.lockMemory && lockMemory();
+
+    std::cout << "  Render CPUs: " << describeCpus(getAllowedCpus()) << "\n";
+    if (config.pipelineDepth > 0) {
+        std::cout << "  Capture CPUs: " << describeCpus(capturePlacement.cpus) << "\n";
+        std::cout << "  Output CPUs: " << describeCpus(outputPlacement.cpus) << "\n";
+    }
+    std::cout << "  Scheduling: " << describeThreadPolicy() << "\n";
+    std::cout << "  Memory lock: " << (memoryLocked ? "enabled" : "disabled") << "\n";
 
     // Default resolution for virtual camera based on config preference
     // This prevents blurry output when consumer connects before camera is probed
@@ -215,28 +607,45 @@ int main(int argc, char* argv[]) {
     double fps = 30.0;
 
     CameraCapture camera;
+    camera.setBackend(config.captureBackend, config.captureBuffers);
+    camera.setMjpegDecoder(config.mjpegDecoder);
 
-    // If not on-demand, open camera immediately
-    if (!config.onDemand) {
+    // Camera discovery and hot-plug watching
+    DeviceManager devices;
+    if (config.inputSpec.empty()) {
+        devices.start();
+    }
+
+    // Headless input replaces the camera entirely
+    FileSource fileSource;
+    const bool fileInput = !config.inputSpec.empty();
+    if (fileInput) {
+        if (!fileSource.open(config.inputSpec)) {
+            std::cerr << "Failed to open input: " << config.inputSpec << "\n";
+            return 1;
+        }
+        width = fileSource.getWidth();
+        height = fileSource.getHeight();
+        std::cout << "Input: " << width << "x" << height << "\n";
+    } else if (!config.onDemand) {
+        // If not on-demand, open camera immediately
         std::cout << "Opening camera (on-demand disabled)...\n";
         if (config.inputDevice.empty()) {
             std::cout << "Auto-detecting camera...\n";
-            if (!camera.detectCamera(config.resolution)) {
+        }
+        if (!tryOpenCamera(devices, camera, config, width, height)) {
+            if (config.inputDevice.empty()) {
                 std::cerr << "Failed to detect camera\n";
-                return 1;
-            }
-        } else {
-            if (!camera.open(config.inputDevice, config.resolution)) {
+            } else {
                 std::cerr << "Failed to open camera: " << config.inputDevice << "\n";
-                return 1;
             }
+            return 1;
         }
-        camera.getResolution(width, height);
         fps = camera.getFPS();
     } else {
         // On-demand mode: probe camera briefly to get resolution, then close
         std::cout << "Probing camera for resolution...\n";
-        if (tryOpenCamera(camera, config, width, height)) {
+        if (tryOpenCamera(devices, camera, config, width, height)) {
             fps = camera.getFPS();
             camera.close();
             std::cout << "Camera probed: " << width << "x" << height << " @ " << fps << " FPS\n";
@@ -246,24 +655,125 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // Initialize virtual output
+    // Initialize the output: the virtual camera, or a headless sink
     VirtualOutput output;
-    if (!output.open(config.outputDevice, width, height, fps)) {
+    FileSink fileSink;
+    ShmSink shmSink;
+    FanOutSink fanOut;
+    FrameSink* directSink = &output;
+    if (config.sinkSpec.rfind("file:", 0) == 0) {
+        if (!fileSink.open(config.sinkSpec.substr(5), width, height)) {
+            std::cerr << "Failed to open output file\n";
+            return 1;
+        }
+        directSink = &fileSink;
+    } else if (config.sinkSpec.rfind("shm:", 0) == 0) {
+        if (!shmSink.open(config.sinkSpec.substr(4), width, height)) {
+            std::cerr << "Failed to open shared-memory output\n";
+            return 1;
+        }
+        directSink = &shmSink;
+    } else if (config.outputs.size() > 1) {
+        if (!fanOut.open(config.outputs, width, height, fps, config.outputBuffers)) {
+            std::cerr << "Failed to open virtual cameras\n";
+            return 1;
+        }
+        directSink = &fanOut;
+    } else if (!output.open(config.outputDevice, config.outputs[0].width ? config.outputs[0].width : width,
+                            config.outputs[0].height ? config.outputs[0].height : height,
+                            fps, config.outputBuffers)) {
         std::cerr << "Failed to open virtual camera\n";
         return 1;
     }
+    const bool fanOutput = directSink == &fanOut;
+    directSink->setScaleFilter(config.scaleFilter);
 
-    // Initialize effects
-    StaticEffect staticEffect;
-    staticEffect.initialize(width, height);
+    // Initialize effects: one instance per sequence step
+    std::vector<std::unique_ptr<Effect>> effects;
+    for (const auto& step : config.effectSequence) {
+        effects.push_back(EffectRegistry::instance().create(step.name, config));
+    }
 
-    MatrixEffect matrixEffect;
-    if (!matrixEffect.initialize(width, height)) {
-        std::cerr << "Warning: Matrix effect initialization had issues\n";
+    // The idle screen reuses a static step if there is one, so the static
+    // frame cache is only built once
+    StaticEffect* idleStatic = nullptr;
+    for (auto& effect : effects) {
+        if ((idleStatic = dynamic_cast<StaticEffect*>(effect.get())) != nullptr) break;
+    }
+    // Otherwise make one the same way, so it gets every static option
+    std::unique_ptr<Effect> ownIdleStatic;
+    if (!idleStatic) {
+        ownIdleStatic = EffectRegistry::instance().create("static", config);
+        idleStatic = dynamic_cast<StaticEffect*>(ownIdleStatic.get());
     }
 
+    auto initializeEffects = [&](int w, int h) {
+        for (auto& effect : effects) {
+            if (!effect->initialize(w, h)) {
+                std::cerr << "Warning: " << effect->name() << " effect initialization had issues\n";
+            }
+        }
+        if (ownIdleStatic) {
+            ownIdleStatic->initialize(w, h);
+        }
+    };
+    // Effects draw at the output size, which stays fixed while consumers
+    // hold the device; only camera frames are ever scaled
+    initializeEffects(directSink->getWidth(), directSink->getHeight());
+
+    // Optional pipeline: capture and output on their own threads, the loop
+    // below only runs the state machine and renders
+    const bool pipelined = config.pipelineDepth > 0;
+    CaptureThread captureThread(config.pipelineDepth);
+    OutputThread outputThread(*directSink, config.pipelineDepth);
+    outputThread.setScaleFilter(config.scaleFilter);
+    captureThread.setPlacement(capturePlacement);
+    outputThread.setPlacement(outputPlacement);
+    // File input is read on this thread; the capture thread drives a camera
+    FrameSource& source = fileInput ? static_cast<FrameSource&>(fileSource)
+                        : pipelined ? static_cast<FrameSource&>(captureThread) : camera;
+    FrameSink& sink = pipelined ? static_cast<FrameSink&>(outputThread) : *directSink;
+    if (pipelined) {
+        outputThread.start();
+        if (camera.isOpened()) {
+            captureThread.start(camera, sink.getWidth(), sink.getHeight());
+        }
+    }
+
+    FrameScheduler scheduler;
+
+    // BGR intermediates (overlay, effects at a size other than the output's)
+    FramePool framePool;
+    uint64_t allocatingFrames = 0;
+    uint64_t loopAllocations = 0;
+
+    // Stage timing; off unless asked for
+    StageStats::setEnabled(config.statsInterval > 0 || !config.statsSocket.empty());
+    StatsServer statsServer;
+    if (!config.statsSocket.empty() && !statsServer.start(config.statsSocket)) {
+        std::cerr << "Warning: stats socket unavailable\n";
+    }
+    uint64_t lastStatsTime = getCurrentTimeMs();
+
+    // Idle static at full character size. Re-rendered on each idle frame
+    // until the static cache is ready (before that it's fallback noise),
+    // then only rewritten.
+    cv::Mat idleFrame;
+    bool idleFrameFinal = false;
+
     // Consumer detector for on-demand mode
-    ConsumerDetector consumerDetector(config.outputDevice);
+    // Fan-out always tracks consumers, so idle outputs cost nothing
+    ConsumerMonitor consumerMonitor(config.outputDevice);
+    if (fanOutput) {
+        fanOut.startMonitors();
+    } else if (config.onDemand) {
+        consumerMonitor.start();
+    }
+    if (config.onDemand) {
+        if (!(fanOutput ? fanOut.isEventDriven() : consumerMonitor.isEventDriven())) {
+            std::cout << "Consumer detection: polling\n";
+        }
+    }
 
     // Random number generator for timing
     std::mt19937 rng(std::random_device{}());
@@ -271,10 +781,13 @@ int main(int argc, char* argv[]) {
     // Camera state (for on-demand mode)
     CameraState cameraState = config.onDemand ? CameraState::IDLE : CameraState::ACTIVE;
     uint64_t lastCameraPollTime = 0;
+    uint64_t lingerStartTime = 0;
+    uint64_t seenDeviceChanges = devices.getChangeCount();
     bool hadConsumers = false;
 
     // Effect state machine
     EffectState effectState = EffectState::PASSTHROUGH;
+    size_t effectStep = 0;
     uint64_t nextEffectTime = 0;
     uint64_t effectStartTime = 0;
     bool effectTimerInitialized = false;
@@ -288,106 +801,124 @@ int main(int argc, char* argv[]) {
         std::cout << "Will run " << config.cycles << " effect cycle(s)\n";
     }
     if (config.onDemand) {
-        std::cout << "Waiting for consumer to connect to " << config.outputDevice << "...\n";
+        std::cout << "Waiting for consumer to connect to " << config.outputDevice
+                  << (fanOutput ? " (or the other outputs)" : "") << "...\n";
     }
 
     // Main loop
     while (running) {
         uint64_t currentTime = getCurrentTimeMs();
+        uint64_t frameStartNs = StageStats::enabled() ? StageTimer::now() : 0;
+        uint64_t allocationsBefore = getAllocationCount();
         cv::Mat outputFrame;
+        FrameKind frameKind = FrameKind::BGR;
         bool hasConsumers = true;
+        bool pacedByCamera = false;
 
         // On-demand mode: check for consumers
+        uint64_t consumerChanges = ConsumerMonitor::getChangeCount();
         if (config.onDemand) {
-            hasConsumers = consumerDetector.hasConsumers();
+            hasConsumers = fanOutput ? fanOut.hasConsumers() : consumerMonitor.hasConsumers();
 
             // Handle consumer connect/disconnect
             if (hasConsumers && !hadConsumers) {
                 std::cout << "Consumer connected!\n";
-                cameraState = CameraState::CONNECTING;
+                if (cameraState == CameraState::LINGER) {
+                    // Still streaming: skip whatever queued up and carry on
+                    camera.flush();
+                    if (pipelined) {
+                        captureThread.start(camera, sink.getWidth(), sink.getHeight());
+                    }
+                    std::cout << "Camera resumed (kept warm)\n";
+                    cameraState = CameraState::ACTIVE;
+                } else {
+                    cameraState = CameraState::CONNECTING;
+                }
             } else if (!hasConsumers && hadConsumers) {
                 std::cout << "Consumer disconnected.\n";
+                devices.cancelOpen();
+                cameraState = CameraState::IDLE;
                 if (camera.isOpened()) {
-                    camera.close();
-                    std::cout << "Camera released.\n";
+                    // With nothing dequeuing, the driver drops frames itself
+                    captureThread.stop();
+                    if (config.cameraLinger > 0) {
+                        std::cout << "Keeping camera warm for " << formatTime(config.cameraLinger) << "\n";
+                        cameraState = CameraState::LINGER;
+                        lingerStartTime = currentTime;
+                    } else {
+                        camera.close();
+                        std::cout << "Camera released.\n";
+                    }
                 }
-                cameraState = CameraState::IDLE;
                 // Reset effect timer for next connection
                 effectTimerInitialized = false;
                 effectState = EffectState::PASSTHROUGH;
-                staticEffect.resetForIdle();  // Start growing animation
+                idleStatic->resetForIdle();  // Start growing animation
             }
             hadConsumers = hasConsumers;
         }
 
         // Handle camera states
         switch (cameraState) {
-            case CameraState::IDLE:
-                // No consumers, output static slowly (low CPU)
-                outputFrame = staticEffect.generate();
-                break;  // Still need to write frame for v4l2loopback
-
-            case CameraState::CONNECTING: {
-                // Save current resolution before trying to open camera
-                int prevW = width;
-                int prevH = height;
-
-                // Try to open camera
-                if (tryOpenCamera(camera, config, width, height)) {
-                    fps = camera.getFPS();
-                    std::cout << "Camera opened: " << width << "x" << height << " @ " << fps << " FPS\n";
-                    cameraState = CameraState::ACTIVE;
-
-                    // Check if resolution changed from what virtual output was configured for
-                    int outputW = output.getWidth();
-                    int outputH = output.getHeight();
-
-                    if (width != outputW || height != outputH) {
-                        // Resolution mismatch - consumer is already connected, can't reconfigure
-                        // v4l2loopback doesn't allow format change while consumer is reading
-                        // We'll scale frames instead (already done in writeFrame)
-                        std::cout << "Note: Camera resolution (" << width << "x" << height
-                                  << ") differs from virtual output (" << outputW << "x" << outputH
-                                  << "). Scaling frames.\n";
-                        // Keep effects at camera resolution for quality
-                        staticEffect.initialize(width, height);
-                        matrixEffect.initialize(width, height);
-                    }
-                } else {
-                    std::cout << "Camera unavailable, polling...\n";
-                    cameraState = CameraState::UNAVAILABLE;
-                    lastCameraPollTime = currentTime;
-                    staticEffect.resetForIdle();  // Start growing animation
+            case CameraState::LINGER:
+                if (currentTime - lingerStartTime >= config.cameraLinger) {
+                    camera.close();
+                    std::cout << "Camera released.\n";
+                    cameraState = CameraState::IDLE;
                 }
-                outputFrame = staticEffect.generate();
+                frameKind = FrameKind::IDLE;
                 break;
-            }
 
-            case CameraState::UNAVAILABLE:
-                // Camera busy, poll periodically
-                if (currentTime - lastCameraPollTime >= config.cameraPollInterval) {
-                    if (tryOpenCamera(camera, config, width, height)) {
+            case CameraState::IDLE:
+                // No consumers: keep v4l2loopback fed with a repeated frame
+                // and sleep on the consumer monitor in between
+                frameKind = FrameKind::IDLE;
+                break;
+
+            case CameraState::CONNECTING:
+            case CameraState::UNAVAILABLE: {
+                // Opening runs on a worker thread and static keeps streaming.
+                // Busy cameras are retried every poll interval, and at once
+                // when a video node appears or goes away.
+                bool opened = false;
+                if (devices.takeOpenResult(opened)) {
+                    if (opened) {
+                        camera.getResolution(width, height);
                         fps = camera.getFPS();
-                        std::cout << "Camera now available: " << width << "x" << height << "\n";
+                        std::cout << (cameraState == CameraState::CONNECTING ? "Camera opened: " : "Camera now available: ")
+                                  << width << "x" << height << " @ " << fps << " FPS\n";
                         cameraState = CameraState::ACTIVE;
+                        if (pipelined) {
+                            captureThread.start(camera, sink.getWidth(), sink.getHeight());
+                        }
 
-                        // Reinitialize effects for camera resolution
-                        staticEffect.initialize(width, height);
-                        matrixEffect.initialize(width, height);
-
-                        // Check if output resolution differs (consumer-locked)
-                        int outputW = output.getWidth();
-                        int outputH = output.getHeight();
-                        if (width != outputW || height != outputH) {
-                            std::cout << "Note: Scaling camera (" << width << "x" << height
-                                      << ") to output (" << outputW << "x" << outputH << ")\n";
-                            // Don't try to reopen output - consumer has it locked
+                        // v4l2loopback doesn't allow a format change while a consumer
+                        // is reading, so camera frames are scaled on write; effects
+                        // already draw at the output size
+                        if (width != sink.getWidth() || height != sink.getHeight()) {
+                            std::cout << "Note: Camera resolution (" << width << "x" << height
+                                      << ") differs from virtual output (" << sink.getWidth() << "x"
+                                      << sink.getHeight() << "). Scaling frames ("
+                                      << scaleFilterName(config.scaleFilter) << ").\n";
+                        }
+                    } else {
+                        if (cameraState == CameraState::CONNECTING) {
+                            std::cout << "Camera unavailable, polling...\n";
+                            idleStatic->resetForIdle();  // Start growing animation
                         }
+                        cameraState = CameraState::UNAVAILABLE;
+                        lastCameraPollTime = currentTime;
                     }
-                    lastCameraPollTime = currentTime;
+                } else if (!devices.isOpening() &&
+                           (cameraState == CameraState::CONNECTING ||
+                            devices.getChangeCount() != seenDeviceChanges ||
+                            currentTime - lastCameraPollTime >= config.cameraPollInterval)) {
+                    seenDeviceChanges = devices.getChangeCount();
+                    devices.openAsync(camera, config.inputDevice, config.resolution);
                 }
-                outputFrame = staticEffect.generate();
+                frameKind = FrameKind::STATIC;
                 break;
+            }
 
             case CameraState::ACTIVE:
                 // Initialize effect timer on first active frame
@@ -407,49 +938,60 @@ int main(int argc, char* argv[]) {
                     effectTimerInitialized = true;
                 }
 
-                // Capture frame from camera
+                // Capture frame from camera; decoding is deferred until a
+                // state actually needs the pixels
                 {
-                    cv::Mat frame = camera.captureFrame();
-                    if (frame.empty()) {
+                    captureThread.setPreferBGR(config.overlay && effectState != EffectState::PASSTHROUGH);
+                    if (!source.grab()) {
+                        if (fileInput) {
+                            std::cout << "End of input after " << fileSource.getFrameCount() << " frames\n";
+                            running = false;
+                            break;
+                        }
                         // Camera might have been disconnected
                         std::cerr << "Failed to capture frame, camera may be unavailable\n";
+                        captureThread.stop();
                         camera.close();
                         cameraState = CameraState::UNAVAILABLE;
                         lastCameraPollTime = currentTime;
-                        outputFrame = staticEffect.generate();
+                        frameKind = FrameKind::STATIC;
                         break;
                     }
+                    pacedByCamera = true;
 
                     // Effect state machine
                     switch (effectState) {
                         case EffectState::PASSTHROUGH:
                             if (!effectsFinished && currentTime >= nextEffectTime) {
-                                effectState = EffectState::STATIC;
+                                effectState = EffectState::EFFECT;
+                                effectStep = 0;
                                 stateStartTime = currentTime;
-                                staticEffect.resetForEffect();  // Full-size static for effect
-                                std::cout << "Effect triggered! Showing static...\n";
+                                effects[0]->reset();
+                                std::cout << "Effect triggered! Showing " << effects[0]->name() << "...\n";
+                                frameKind = FrameKind::EFFECT;
+                                break;
                             }
-                            outputFrame = frame;
-                            break;
-
-                        case EffectState::STATIC:
-                            outputFrame = staticEffect.generate();
-                            if (currentTime - stateStartTime >= config.staticDuration) {
-                                effectState = EffectState::MATRIX;
-                                stateStartTime = currentTime;
-                                matrixEffect.reset();
-                                std::cout << "Showing matrix effect...\n";
+                            // Camera already delivers what the output wants: forward
+                            // the driver buffer with no decode or re-encode
+                            if (source.retrieveYUYV(outputFrame) &&
+                                outputFrame.cols == sink.getWidth() &&
+                                outputFrame.rows == sink.getHeight()) {
+                                frameKind = FrameKind::YUYV;
+                            } else if (source.canDecodeYUYV(sink.getWidth(), sink.getHeight())) {
+                                frameKind = FrameKind::MJPEG;
+                            } else {
+                                outputFrame = source.retrieve();
                             }
                             break;
 
-                        case EffectState::MATRIX:
-                            matrixEffect.update(currentTime);
-                            if (config.overlay) {
-                                outputFrame = matrixEffect.renderOverlay(frame, 0.9f);
-                            } else {
-                                outputFrame = matrixEffect.render();
-                            }
-                            if (currentTime - stateStartTime >= config.effectDuration) {
+                        case EffectState::EFFECT:
+                            if (currentTime - stateStartTime >= config.effectSequence[effectStep].duration &&
+                                effectStep + 1 < effects.size()) {
+                                effectStep++;
+                                stateStartTime = currentTime;
+                                effects[effectStep]->reset();
+                                std::cout << "Showing " << effects[effectStep]->name() << " effect...\n";
+                            } else if (currentTime - stateStartTime >= config.effectSequence[effectStep].duration) {
                                 effectState = EffectState::PASSTHROUGH;
                                 cycleCount++;
 
@@ -461,6 +1003,13 @@ int main(int argc, char* argv[]) {
                                     std::cout << "Returning to passthrough. Next effect in "
                                               << formatTime(nextEffectTime - currentTime) << "\n";
                                 }
+                                outputFrame = source.retrieve();
+                                break;
+                            }
+
+                            frameKind = FrameKind::EFFECT;
+                            if (config.overlay && effects[effectStep]->supportsOverlay()) {
+                                outputFrame = source.retrieve();
                             }
                             break;
                     }
@@ -468,20 +1017,125 @@ int main(int argc, char* argv[]) {
                 break;
         }
 
-        // Write to virtual camera
-        if (!outputFrame.empty()) {
-            output.writeFrame(outputFrame);
+        // Write to virtual camera. Effects at the output size render straight
+        // into its YUYV buffer; anything else goes through BGR conversion.
+        switch (frameKind) {
+            case FrameKind::STATIC:
+            case FrameKind::EFFECT: {
+                Effect& effect = frameKind == FrameKind::STATIC ? *idleStatic : *effects[effectStep];
+                BlendMode mode = outputFrame.empty() ? BlendMode::REPLACE : BlendMode::OVERLAY;
+                bool direct = effect.getWidth() == sink.getWidth() && effect.getHeight() == sink.getHeight();
+                cv::Mat& target = direct ? sink.acquireBuffer()
+                                         : framePool.acquire(effect.getHeight(), effect.getWidth(), CV_8UC3);
+                {
+                    StageTimer timer(Stage::RENDER);
+                    effect.update(currentTime);
+                    effect.renderInto(target, direct ? PixelFormat::YUYV : PixelFormat::BGR24, mode, outputFrame);
+                }
+                if (direct) {
+                    sink.commitBuffer();
+                } else {
+                    sink.writeFrame(target);
+                }
+                break;
+            }
+
+            case FrameKind::IDLE:
+                if (idleFrame.empty() || !idleFrameFinal) {
+                    StageTimer timer(Stage::RENDER);
+                    idleFrameFinal = idleStatic->getMode() == StaticMode::PROCEDURAL ||
+                                     !idleStatic->isFontLoaded() || idleStatic->isCacheComplete();
+                    idleStatic->resetForEffect();  // Full-size characters, not the start of the grow animation
+                    idleStatic->update(currentTime);
+                    idleStatic->renderInto(idleFrame, PixelFormat::YUYV);
+                }
+                sink.writeFrameYUYV(idleFrame);
+                break;
+
+            case FrameKind::BGR:
+                if (!outputFrame.empty()) {
+                    sink.writeFrame(outputFrame);
+                }
+                break;
+
+            case FrameKind::YUYV:
+                sink.writeFrameYUYV(outputFrame);
+                break;
+
+            case FrameKind::MJPEG:
+                if (source.decodeYUYV(sink.acquireBuffer())) {
+                    sink.commitBuffer();
+                } else {
+                    // Unusual JPEG layout or corrupt frame: take the BGR path
+                    cv::Mat frame = source.retrieve();
+                    if (!frame.empty()) {
+                        sink.writeFrame(frame);
+                    }
+                }
+                break;
+        }
+
+        if (fileSink.isBroken()) {
+            std::cout << "Output closed, stopping\n";
+            running = false;
+        }
+
+        // Steady state should allocate nothing; only state changes may
+        uint64_t frameAllocations = getAllocationCount() - allocationsBefore;
+        if (frameAllocations > 0) {
+            allocatingFrames++;
+            loopAllocations += frameAllocations;
+        }
+
+        if (StageStats::enabled()) {
+            StageStats& stats = StageStats::instance();
+            stats.record(Stage::FRAME, StageTimer::now() - frameStartNs);
+            stats.set(Counter::CAPTURE_DROPS, captureThread.getDropped());
+            stats.set(Counter::OUTPUT_DROPS, outputThread.getDropped());
+            stats.set(Counter::MISSED_DEADLINES, scheduler.getStats().missed);
+            if (config.statsInterval > 0 && currentTime - lastStatsTime >= config.statsInterval) {
+                std::cout << stats.formatInterval((currentTime - lastStatsTime) / 1000.0) << "\n";
+                lastStatsTime = currentTime;
+            }
         }
 
-        // Frame rate control
-        int frameDelayMs = static_cast<int>(1000.0 / fps);
-        if (frameDelayMs < 1) frameDelayMs = 1;
-        cv::waitKey(frameDelayMs);
+        // Frame rate control: grab() blocked until the camera had a frame,
+        // otherwise wait for the next deadline
+        scheduler.setFrameRate(fps);
+        if (frameKind == FrameKind::IDLE) {
+            // Until a consumer shows up, the next idle frame is due or the
+            // linger window closes
+            uint64_t idleWait = config.idleInterval;
+            if (cameraState == CameraState::LINGER) {
+                uint64_t lingered = getCurrentTimeMs() - lingerStartTime;
+                idleWait = std::min(idleWait, lingered < config.cameraLinger ? config.cameraLinger - lingered : 0);
+            }
+            ConsumerMonitor::waitForChange(consumerChanges, static_cast<int>(idleWait));
+            scheduler.restart();
+        } else if (pacedByCamera) {
+            scheduler.frameDelivered();
+        } else {
+            scheduler.waitForDeadline();
+        }
     }
 
     std::cout << "\nShutting down...\n";
+    FrameScheduler::Stats pacing = scheduler.getStats();
+    std::cout << "Frame pacing: " << pacing.frames << " frames, " << pacing.missed
+              << " missed deadlines, jitter " << pacing.jitterMs << " ms (max "
+              << pacing.maxJitterMs << " ms)\n";
+    std::cout << "Allocations: " << loopAllocations << " in " << allocatingFrames << " of "
+              << pacing.frames << " frames\n";
+    captureThread.stop();
+    outputThread.stop();
+    if (pipelined) {
+        std::cout << "Dropped frames: " << captureThread.getDropped() << " capture, "
+                  << outputThread.getDropped() << " output\n";
+    }
+    devices.stop();
     camera.close();
     output.close();
+    fanOut.close();
 
     return 0;
 }
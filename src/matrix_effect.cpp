@@ -1,10 +1,27 @@
 #include "matrix_effect.h"
+#include "effect_kernels.h"
+#include "pixel_convert.h"
 #include <iostream>
 #include <codecvt>
 #include <locale>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+const char* colorThemeName(ColorTheme theme) {
+    switch (theme) {
+        case ColorTheme::GREEN: return "green";
+        case ColorTheme::AMBER: return "amber";
+        case ColorTheme::CYAN:  return "cyan";
+        case ColorTheme::RED:   return "red";
+        case ColorTheme::WHITE: return "white";
+    }
+    return "unknown";
+}
 
-MatrixEffect::MatrixEffect() : rng_(std::random_device{}()) {
+MatrixEffect::MatrixEffect() {
     loadCharacters();
+    buildPalette();
 }
 
 MatrixEffect::~MatrixEffect() {
@@ -16,6 +33,61 @@ MatrixEffect::~MatrixEffect() {
     }
 }
 
+void MatrixEffect::setRenderThreads(int threads) {
+    if (threads == 1) {
+        renderPool_.reset();
+        return;
+    }
+    // The calling thread takes part, so ask for one worker fewer
+    renderPool_ = std::make_unique<ThreadPool>(threads <= 0 ? 0 : threads - 1);
+}
+
+void MatrixEffect::setTheme(ColorTheme theme) {
+    theme_ = theme;
+    buildPalette();
+    // The layer is unchanged; only its YUYV mirror has to be recoloured
+    std::fill(yuyvDirty_.begin(), yuyvDirty_.end(), 1);
+}
+
+void MatrixEffect::buildPalette() {
+    // {B, G, R} of the trail at full brightness and of the head glyph
+    struct ThemeColors { int trail[3]; int head[3]; };
+    ThemeColors colors;
+    switch (theme_) {
+        case ColorTheme::AMBER: colors = {{0, 170, 255}, {190, 235, 255}}; break;
+        case ColorTheme::CYAN:  colors = {{255, 230, 0}, {255, 255, 210}}; break;
+        case ColorTheme::RED:   colors = {{40, 40, 255}, {210, 210, 255}}; break;
+        case ColorTheme::WHITE: colors = {{220, 220, 220}, {255, 255, 255}}; break;
+        case ColorTheme::GREEN:
+        default:                colors = {{0, 255, 0}, {200, 255, 200}}; break;
+    }
+
+    auto scaled = [](int c, int num, int den) { return static_cast<uint8_t>((c * num + den / 2) / den); };
+    for (int i = 0; i < HEAD_BASE; ++i) {
+        const int* c = colors.trail;
+        palette_.set(i, scaled(c[0], i, HEAD_BASE - 1), scaled(c[1], i, HEAD_BASE - 1),
+                     scaled(c[2], i, HEAD_BASE - 1));
+    }
+    const int headLevels = 256 - HEAD_BASE;
+    for (int k = 0; k < headLevels; ++k) {
+        const int* c = colors.head;
+        palette_.set(HEAD_BASE + k, scaled(c[0], k + 1, headLevels), scaled(c[1], k + 1, headLevels),
+                     scaled(c[2], k + 1, headLevels));
+    }
+}
+
+template <typename Fn>
+void MatrixEffect::forEachBand(int count, int bandSize, Fn&& fn) {
+    // fn(begin, end) for consecutive bands of [0, count)
+    int bands = (count + bandSize - 1) / bandSize;
+    auto band = [&](int b) { fn(b * bandSize, std::min(count, (b + 1) * bandSize)); };
+    if (renderPool_) {
+        renderPool_->parallelFor(bands, band);
+    } else {
+        for (int b = 0; b < bands; ++b) band(b);
+    }
+}
+
 void MatrixEffect::loadCharacters() {
     // Half-width Katakana (like the original Matrix)
     characters_ = {
@@ -63,49 +135,65 @@ bool MatrixEffect::initFreeType() {
     return false;
 }
 
-void MatrixEffect::renderGlyph(cv::Mat& img, const std::string& ch, int x, int y, cv::Scalar color) {
-    if (!ftInitialized_ || x < 0 || y < 0) return;
+void MatrixEffect::buildGlyphAtlas() {
+    glyphAtlas_.clear();
+    glyphAtlas_.resize(characters_.size());
+    if (!ftInitialized_) return;
 
-    // Convert UTF-8 string to Unicode codepoint
     std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
-    std::u32string u32str;
-    try {
-        u32str = converter.from_bytes(ch);
-    } catch (...) {
-        return;
-    }
-    if (u32str.empty()) return;
 
-    char32_t codepoint = u32str[0];
+    for (size_t i = 0; i < characters_.size(); ++i) {
+        // Convert UTF-8 string to Unicode codepoint
+        std::u32string u32str;
+        try {
+            u32str = converter.from_bytes(characters_[i]);
+        } catch (...) {
+            continue;
+        }
+        if (u32str.empty()) continue;
 
-    // Load glyph
-    FT_UInt glyphIndex = FT_Get_Char_Index(ftFace_, codepoint);
-    if (glyphIndex == 0) return;
+        FT_UInt glyphIndex = FT_Get_Char_Index(ftFace_, u32str[0]);
+        if (glyphIndex == 0) continue;
 
-    if (FT_Load_Glyph(ftFace_, glyphIndex, FT_LOAD_RENDER)) return;
+        if (FT_Load_Glyph(ftFace_, glyphIndex, FT_LOAD_RENDER)) continue;
 
-    FT_GlyphSlot slot = ftFace_->glyph;
-    FT_Bitmap& bitmap = slot->bitmap;
+        FT_GlyphSlot slot = ftFace_->glyph;
+        FT_Bitmap& bitmap = slot->bitmap;
+        if (bitmap.rows == 0 || bitmap.width == 0) continue;
+
+        GlyphBitmap& glyph = glyphAtlas_[i];
+        glyph.left = slot->bitmap_left;
+        glyph.top = slot->bitmap_top;
+        glyph.alpha.create(bitmap.rows, bitmap.width, CV_8UC1);
+        for (unsigned int row = 0; row < bitmap.rows; ++row) {
+            std::memcpy(glyph.alpha.ptr(row), bitmap.buffer + row * bitmap.pitch, bitmap.width);
+        }
+    }
+}
+
+void MatrixEffect::renderGlyph(cv::Mat& img, const GlyphBitmap& glyph, int x, int y, int base, int span) {
+    if (glyph.alpha.empty() || x < 0 || y < 0) return;
 
     // Draw the glyph
-    int startX = x + slot->bitmap_left;
-    int startY = y - slot->bitmap_top;
-
-    for (unsigned int row = 0; row < bitmap.rows; ++row) {
-        for (unsigned int col = 0; col < bitmap.width; ++col) {
-            int px = startX + col;
-            int py = startY + row;
-
-            if (px >= 0 && px < img.cols && py >= 0 && py < img.rows) {
-                unsigned char alpha = bitmap.buffer[row * bitmap.pitch + col];
-                if (alpha > 0) {
-                    cv::Vec3b& pixel = img.at<cv::Vec3b>(py, px);
-                    float a = alpha / 255.0f;
-                    pixel[0] = static_cast<uchar>(pixel[0] * (1 - a) + color[0] * a);
-                    pixel[1] = static_cast<uchar>(pixel[1] * (1 - a) + color[1] * a);
-                    pixel[2] = static_cast<uchar>(pixel[2] * (1 - a) + color[2] * a);
-                }
-            }
+    int startX = x + glyph.left;
+    int startY = y - glyph.top;
+
+    // Horizontal clip is the same for every row
+    int colStart = std::max(0, -startX);
+    int colEnd = std::min(glyph.alpha.cols, img.cols - startX);
+    if (colStart >= colEnd) return;
+
+    // Covered pixels get base + alpha * span / 255; where glyphs overlap the higher index wins
+    for (int row = 0; row < glyph.alpha.rows; ++row) {
+        int py = startY + row;
+        if (py < 0 || py >= img.rows) continue;
+
+        uchar* dst = img.ptr(py) + startX;
+        const uint8_t* alpha = glyph.alpha.ptr(row);
+        for (int col = colStart; col < colEnd; ++col) {
+            if (alpha[col] == 0) continue;
+            int index = base + (alpha[col] * span + 127) / 255;
+            dst[col] = std::max(dst[col], static_cast<uchar>(index));
         }
     }
 }
@@ -113,53 +201,66 @@ void MatrixEffect::renderGlyph(cv::Mat& img, const std::string& ch, int x, int y
 bool MatrixEffect::initialize(int width, int height) {
     width_ = width;
     height_ = height;
-    buffer_ = cv::Mat::zeros(height_, width_, CV_8UC3);
+    buffer_ = cv::Mat::zeros(height_, width_, CV_8UC1);
 
     if (!initFreeType()) {
         std::cerr << "Warning: FreeType init failed, matrix effect may not render correctly" << std::endl;
     }
 
+    // Rasterize every character once; glyph size doesn't depend on resolution
+    if (glyphAtlas_.empty()) {
+        buildGlyphAtlas();
+    }
+
     // Calculate number of columns based on character width
     numColumns_ = width_ / charWidth_;
-    columns_.resize(numColumns_);
+    headY_.assign(numColumns_, 0);
+    speed_.assign(numColumns_, 0);
+    trailLength_.assign(numColumns_, 0);
+    trailGlyphs_.assign(static_cast<size_t>(numColumns_) * MAX_TRAIL, 0);
+    tickRandom_.assign(numColumns_, 0);
 
     // Initialize each column with random state
-    for (auto& col : columns_) {
-        initializeColumn(col);
+    for (int colIdx = 0; colIdx < numColumns_; ++colIdx) {
+        initializeColumn(colIdx);
         // Randomize initial head position for varied start
-        col.headPosition = -(rng_() % height_);
+        headY_[colIdx] = -static_cast<int>(rng_.below(height_));
     }
 
     lastUpdateTime_ = 0;
+    columnDirty_.assign(numColumns_, 1);
+    dirtyList_.reserve(numColumns_);
+    frameDirty_ = true;
+
+    // Black in YUYV; the unused strip past the last column never changes
+    yuyvBuffer_.create(height_, width_, CV_8UC2);
+    yuyvBuffer_.setTo(cv::Scalar(16, 128));
+    yuyvDirty_.assign(numColumns_, 0);
+    int rowBands = (height_ + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    scratchRow_.assign(static_cast<size_t>(width_) * 6 * rowBands, 0);
     return true;
 }
 
-void MatrixEffect::initializeColumn(MatrixColumn& col) {
-    col.speed = speedDist_(rng_);
-    col.trailLength = trailDist_(rng_);
-    col.headPosition = -col.trailLength * charHeight_;
-    col.lastUpdate = 0;
+void MatrixEffect::initializeColumn(int colIdx) {
+    speed_[colIdx] = rng_.range(MIN_SPEED, MAX_SPEED);
+    trailLength_[colIdx] = rng_.range(MIN_TRAIL, MAX_TRAIL);
+    headY_[colIdx] = -trailLength_[colIdx] * charHeight_;
 
-    // Fill with random characters
-    col.charIndices.resize(col.trailLength);
-    for (int& idx : col.charIndices) {
-        idx = randomChar();
+    // Fill with random characters; slots past the trail length are unused
+    uint8_t* glyphs = &trailGlyphs_[static_cast<size_t>(colIdx) * MAX_TRAIL];
+    for (int i = 0; i < trailLength_[colIdx]; ++i) {
+        glyphs[i] = static_cast<uint8_t>(randomChar());
     }
 }
 
 int MatrixEffect::randomChar() {
-    return rng_() % characters_.size();
+    return static_cast<int>(rng_.below(static_cast<uint32_t>(characters_.size())));
 }
 
-cv::Scalar MatrixEffect::getCharColor(int distanceFromHead) const {
-    if (distanceFromHead == 0) {
-        // Head character is bright white-green
-        return cv::Scalar(200, 255, 200);
-    }
-
-    // Fade from bright green to dark green
+int MatrixEffect::getCharLevel(int distanceFromHead) const {
+    // Trail index at full coverage, fading from the trail colour to a fifth of it
     int brightness = std::max(50, 255 - distanceFromHead * 15);
-    return cv::Scalar(0, brightness, 0);
+    return (brightness * (HEAD_BASE - 1) + 127) / 255;
 }
 
 void MatrixEffect::update(uint64_t currentTimeMs) {
@@ -174,88 +275,156 @@ void MatrixEffect::update(uint64_t currentTimeMs) {
 
     lastUpdateTime_ = currentTimeMs;
 
-    for (auto& col : columns_) {
-        // Move column down
-        col.headPosition += col.speed;
+    // Move every column down in one pass
+    int* headY = headY_.data();
+    const int* speed = speed_.data();
+    for (int colIdx = 0; colIdx < numColumns_; ++colIdx) {
+        headY[colIdx] += speed[colIdx];
+    }
+
+    rng_.fill(tickRandom_.data(), tickRandom_.size());
+    for (int colIdx = 0; colIdx < numColumns_; ++colIdx) {
+        int trailLength = trailLength_[colIdx];
+        bool wasVisible = isColumnVisible(headY[colIdx] - speed[colIdx], trailLength);
 
         // Randomly change some characters
-        if (rng_() % 10 == 0 && !col.charIndices.empty()) {
-            int changeIdx = rng_() % col.charIndices.size();
-            col.charIndices[changeIdx] = randomChar();
+        uint32_t r = tickRandom_[colIdx];
+        if (FastRng::scale(r, 10) == 0) {
+            int changeIdx = static_cast<int>(rng_.below(trailLength));
+            trailGlyphs_[static_cast<size_t>(colIdx) * MAX_TRAIL + changeIdx] =
+                static_cast<uint8_t>(randomChar());
         }
 
         // Reset column when it goes off screen
-        if (col.headPosition > height_ + col.trailLength * charHeight_) {
-            initializeColumn(col);
+        if (headY[colIdx] > height_ + trailLength * charHeight_) {
+            initializeColumn(colIdx);
+        }
+
+        // Columns that stay entirely off-screen leave their strip untouched
+        if (wasVisible || isColumnVisible(headY[colIdx], trailLength_[colIdx])) {
+            columnDirty_[colIdx] = 1;
+            frameDirty_ = true;
         }
     }
 }
 
-cv::Mat MatrixEffect::render() {
-    // Clear to black
-    buffer_.setTo(cv::Scalar(0, 0, 0));
+bool MatrixEffect::isColumnVisible(int headY, int trailLength) const {
+    int tailY = headY - (trailLength - 1) * charHeight_;
+    return headY >= -charHeight_ && tailY <= height_ + charHeight_;
+}
 
-    for (int colIdx = 0; colIdx < numColumns_; ++colIdx) {
-        const auto& col = columns_[colIdx];
-        int x = colIdx * charWidth_ + 2;
+void MatrixEffect::markAllDirty() {
+    std::fill(columnDirty_.begin(), columnDirty_.end(), 1);
+    frameDirty_ = true;
+}
 
-        for (int i = 0; i < static_cast<int>(col.charIndices.size()); ++i) {
-            int y = col.headPosition - i * charHeight_;
+void MatrixEffect::renderColumn(cv::Mat& strip, int colIdx) {
+    strip.setTo(cv::Scalar(0));
 
-            // Skip if outside visible area
-            if (y < -charHeight_ || y > height_ + charHeight_) {
-                continue;
-            }
+    const uint8_t* glyphs = &trailGlyphs_[static_cast<size_t>(colIdx) * MAX_TRAIL];
+    for (int i = 0; i < trailLength_[colIdx]; ++i) {
+        int y = headY_[colIdx] - i * charHeight_;
 
-            cv::Scalar color = getCharColor(i);
-            const std::string& ch = characters_[col.charIndices[i]];
+        // Skip if outside visible area
+        if (y < -charHeight_ || y > height_ + charHeight_) {
+            continue;
+        }
 
-            if (ftInitialized_) {
-                renderGlyph(buffer_, ch, x, y, color);
-            }
+        // The head character has its own, brighter colour
+        if (i == 0) {
+            renderGlyph(strip, glyphAtlas_[glyphs[i]], 2, y, HEAD_BASE, 255 - HEAD_BASE);
+        } else {
+            renderGlyph(strip, glyphAtlas_[glyphs[i]], 2, y, 0, getCharLevel(i));
         }
     }
+}
+
+void MatrixEffect::redrawDirtyColumns() {
+    // State only advances every UPDATE_INTERVAL_MS; in between the last frame is still valid
+    if (!frameDirty_) return;
+
+    dirtyList_.clear();
+    for (int colIdx = 0; colIdx < numColumns_; ++colIdx) {
+        if (!columnDirty_[colIdx]) continue;
+        dirtyList_.push_back(colIdx);
+        columnDirty_[colIdx] = 0;
+        yuyvDirty_[colIdx] = 1;
+    }
 
-    return buffer_.clone();
+    // Each column owns a charWidth_-wide strip and glyphs are clipped to it,
+    // so strips can be drawn concurrently
+    forEachBand(static_cast<int>(dirtyList_.size()), COLUMNS_PER_TASK, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            int colIdx = dirtyList_[i];
+            cv::Mat strip = buffer_(cv::Rect(colIdx * charWidth_, 0, charWidth_, height_));
+            renderColumn(strip, colIdx);
+        }
+    });
+    frameDirty_ = false;
 }
 
-cv::Mat MatrixEffect::renderOverlay(const cv::Mat& background, float opacity) {
-    // Resize background if needed
-    cv::Mat bg;
-    if (background.cols != width_ || background.rows != height_) {
-        cv::resize(background, bg, cv::Size(width_, height_));
-    } else {
-        bg = background.clone();
+void MatrixEffect::refreshYUYV() {
+    // Convert each run of redrawn strips in one pass
+    int colIdx = 0;
+    while (colIdx < numColumns_) {
+        if (!yuyvDirty_[colIdx]) {
+            ++colIdx;
+            continue;
+        }
+        int runStart = colIdx;
+        while (colIdx < numColumns_ && yuyvDirty_[colIdx]) {
+            yuyvDirty_[colIdx++] = 0;
+        }
+        paletteToYUYVColumns(buffer_, yuyvBuffer_, runStart * charWidth_, colIdx * charWidth_, palette_);
     }
+}
 
-    // Render matrix effect on black buffer
-    cv::Mat matrixLayer = render();
+void MatrixEffect::renderInto(cv::Mat& dst, PixelFormat format, BlendMode mode,
+                              const cv::Mat& background, float opacity) {
+    if (background.empty()) {
+        mode = BlendMode::REPLACE;
+    }
+    dst.create(height_, width_, pixelFormatType(format));
+    redrawDirtyColumns();
+    dispatchRender(format, mode, [&](auto f, auto m) {
+        renderAs<decltype(f)::value, decltype(m)::value>(dst, background, opacity);
+    });
+}
 
-    // Blend: where matrix has content (non-black), overlay it on background
-    // For pixels with matrix content, use: result = bg * (1-opacity) + matrix * opacity
-    for (int y = 0; y < height_; ++y) {
-        cv::Vec3b* bgRow = bg.ptr<cv::Vec3b>(y);
-        const cv::Vec3b* matrixRow = matrixLayer.ptr<cv::Vec3b>(y);
-
-        for (int x = 0; x < width_; ++x) {
-            const cv::Vec3b& mp = matrixRow[x];
-            // Check if matrix pixel has content (not pure black)
-            if (mp[0] > 0 || mp[1] > 0 || mp[2] > 0) {
-                cv::Vec3b& bp = bgRow[x];
-                bp[0] = static_cast<uchar>(bp[0] * (1.0f - opacity) + mp[0] * opacity);
-                bp[1] = static_cast<uchar>(bp[1] * (1.0f - opacity) + mp[1] * opacity);
-                bp[2] = static_cast<uchar>(bp[2] * (1.0f - opacity) + mp[2] * opacity);
-            }
+template <PixelFormat F, BlendMode M>
+void MatrixEffect::renderAs(cv::Mat& dst, const cv::Mat& background, float opacity) {
+    // On black, YUYV output comes from the incrementally updated mirror
+    if constexpr (F == PixelFormat::YUYV && M == BlendMode::REPLACE) {
+        refreshYUYV();
+        yuyvBuffer_.copyTo(dst);
+        return;
+    }
+
+    const cv::Mat* bg = &background;
+    if constexpr (M == BlendMode::OVERLAY) {
+        if (background.cols != width_ || background.rows != height_) {
+            backgroundScaler_.toBGR(background, background_, width_, height_);
+            bg = &background_;
         }
     }
 
-    return bg;
+    // Blend: where matrix has content (non-black), overlay it on background
+    // For pixels with matrix content, use: result = bg * (1-opacity) + matrix * opacity
+    int weight = static_cast<int>(std::lround(std::clamp(opacity, 0.0f, 1.0f) * 256.0f));
+    forEachBand(height_, ROWS_PER_TASK, [&](int begin, int end) {
+        uint8_t* scratch = scratchRow_.data() + static_cast<size_t>(begin / ROWS_PER_TASK) * width_ * 6;
+        for (int y = begin; y < end; ++y) {
+            const uint8_t* bgRow = (M == BlendMode::OVERLAY) ? bg->ptr(y) : nullptr;
+            composePaletteRow<F, M>(dst.ptr(y), buffer_.ptr(y), bgRow, scratch, width_, weight, palette_);
+        }
+    });
 }
 
 void MatrixEffect::reset() {
-    for (auto& col : columns_) {
-        initializeColumn(col);
-        col.headPosition = -(rng_() % height_);
+    for (int colIdx = 0; colIdx < numColumns_; ++colIdx) {
+        initializeColumn(colIdx);
+        headY_[colIdx] = -static_cast<int>(rng_.below(height_));
     }
     lastUpdateTime_ = 0;
+    markAllDirty();
 }
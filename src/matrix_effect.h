@@ -3,37 +3,69 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <string>
-#include <random>
 #include <map>
+#include <memory>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include "glyph_bitmap.h"
+#include "effect.h"
+#include "thread_pool.h"
+#include "fast_rng.h"
+#include "frame_scaler.h"
+#include "pixel_convert.h"
+#include "config.h"
 
-struct MatrixColumn {
-    std::vector<int> charIndices;   // Indices into character set
-    int headPosition;                // Y position of leading character (in pixels)
-    int speed;                       // Pixels per update
-    int trailLength;                 // Number of characters in trail
-    uint64_t lastUpdate;             // Last update timestamp
-};
+const char* colorThemeName(ColorTheme theme);
 
-class MatrixEffect {
+class MatrixEffect : public Effect {
 public:
     MatrixEffect();
-    ~MatrixEffect();
+    ~MatrixEffect() override;
+
+    const char* name() const override { return "matrix"; }
+    // 1 renders on the calling thread, 0 uses every core; applies immediately
+    void setRenderThreads(int threads);
+    void setSeed(uint32_t seed) { rng_.setSeed(seed); }  // Reproducible columns from the next reset
+    void setScaleFilter(ScaleFilter filter) { backgroundScaler_.setFilter(filter); }  // Overlay backgrounds
+    void setTheme(ColorTheme theme);  // Only rebuilds the palette; applies from the next frame
+    bool initialize(int width, int height) override;
+    void update(uint64_t currentTimeMs) override;
+    void renderInto(cv::Mat& dst, PixelFormat format, BlendMode mode = BlendMode::REPLACE,
+                    const cv::Mat& background = cv::Mat(), float opacity = 0.9f) override;
+    bool supportsOverlay() const override { return true; }
+    void reset() override;
 
-    bool initialize(int width, int height);
-    void update(uint64_t currentTimeMs);
-    cv::Mat render();
-    cv::Mat renderOverlay(const cv::Mat& background, float opacity = 0.9f);
-    void reset();
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
 
 private:
+    static constexpr int COLUMNS_PER_TASK = 8;   // Strips redrawn per parallel work item
+    static constexpr int ROWS_PER_TASK = 64;     // Rows composed per parallel work item
+    static constexpr int MIN_TRAIL = 8;
+    static constexpr int MAX_TRAIL = 30;         // Longest trail; glyph slots per column
+    static constexpr int MIN_SPEED = 4;          // Pixels per update
+    static constexpr int MAX_SPEED = 10;
+
+    // The layer holds palette indices: trail glyphs use [0, HEAD_BASE) as a
+    // brightness ramp, the head glyph [HEAD_BASE, 256) as coverage of its colour
+    static constexpr int HEAD_BASE = 192;
+
+    template <typename Fn> void forEachBand(int count, int bandSize, Fn&& fn);
+    template <PixelFormat F, BlendMode M>
+    void renderAs(cv::Mat& dst, const cv::Mat& background, float opacity);
+    void refreshYUYV();
     void loadCharacters();
     bool initFreeType();
-    void renderGlyph(cv::Mat& img, const std::string& ch, int x, int y, cv::Scalar color);
-    void initializeColumn(MatrixColumn& col);
+    void buildGlyphAtlas();
+    void renderGlyph(cv::Mat& img, const GlyphBitmap& glyph, int x, int y, int base, int span);
+    void renderColumn(cv::Mat& strip, int colIdx);
+    void redrawDirtyColumns();
+    bool isColumnVisible(int headY, int trailLength) const;
+    void markAllDirty();
+    void initializeColumn(int colIdx);
     int randomChar();
-    cv::Scalar getCharColor(int distanceFromHead) const;
+    int getCharLevel(int distanceFromHead) const;
+    void buildPalette();
 
     int width_ = 0;
     int height_ = 0;
@@ -41,18 +73,40 @@ private:
     int charHeight_ = 17;     // Slightly larger chars
     int numColumns_ = 0;
 
-    std::vector<MatrixColumn> columns_;
+    // Column state as parallel arrays, one entry per column
+    std::vector<int> headY_;                // Y of the leading character (pixels)
+    std::vector<int> speed_;                // Pixels per update
+    std::vector<int> trailLength_;          // Characters in the trail
+    std::vector<uint8_t> trailGlyphs_;      // MAX_TRAIL character indices per column, head first
     std::vector<std::string> characters_;
-    cv::Mat buffer_;
+    std::vector<GlyphBitmap> glyphAtlas_;   // One entry per characters_ element
+    cv::Mat buffer_;                        // Palette indices, persists between render() calls
+    ColorTheme theme_ = ColorTheme::GREEN;
+    ColorPalette palette_;
+
+    // Incremental rendering: only strips whose column moved are redrawn
+    std::vector<uint8_t> columnDirty_;
+    std::vector<int> dirtyList_;            // Dirty column indices for the current redraw
+    bool frameDirty_ = true;
+
+    // YUYV mirror of buffer_; strips are re-converted only after a redraw
+    cv::Mat yuyvBuffer_;
+    std::vector<uint8_t> yuyvDirty_;
+
+    cv::Mat background_;                    // Overlay background at our size, if it had to be scaled
+    FrameScaler backgroundScaler_;
+    std::vector<uint8_t> scratchRow_;       // Coloured and blended BGR rows per row band, for overlay output
+
+    // Strip redraw and row composition are split across this pool when set
+    std::unique_ptr<ThreadPool> renderPool_;
 
     // FreeType
     FT_Library ftLibrary_ = nullptr;
     FT_Face ftFace_ = nullptr;
     bool ftInitialized_ = false;
 
-    std::mt19937 rng_;
-    std::uniform_int_distribution<int> speedDist_{4, 10};   // Slower speeds
-    std::uniform_int_distribution<int> trailDist_{8, 30};   // Longer trails
+    FastRng rng_;
+    std::vector<uint32_t> tickRandom_;      // One value per column per update
 
     uint64_t lastUpdateTime_ = 0;
     static constexpr int UPDATE_INTERVAL_MS = 50;  // ~20 FPS for smoother animation
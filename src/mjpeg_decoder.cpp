@@ -0,0 +1,253 @@
+#include "mjpeg_decoder.h"
+#include <iostream>
+#include <vector>
+#include <array>
+
+#ifdef HAVE_LIBJPEG
+#include <cstdio>
+#include <csetjmp>
+#include <jpeglib.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// OpenCV (cv::imdecode) decoder: always available, full-size BGR only
+// ---------------------------------------------------------------------------
+
+class OpenCVMjpegDecoder : public MjpegDecoder {
+public:
+    const char* name() const override { return "opencv"; }
+
+    bool decodeBGR(const uint8_t* data, size_t size, cv::Mat& dst) override {
+        cv::Mat jpeg(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t*>(data));
+        cv::imdecode(jpeg, cv::IMREAD_COLOR, &dst);
+        return !dst.empty();
+    }
+
+    bool canDecodeYUYV(int srcW, int srcH, int dstW, int dstH) const override {
+        return srcW == dstW && srcH == dstH;
+    }
+
+    bool decodeYUYV(const uint8_t* data, size_t size, cv::Mat& dst) override {
+        if (!decodeBGR(data, size, bgr_) || bgr_.cols != dst.cols || bgr_.rows != dst.rows) {
+            return false;
+        }
+        cv::cvtColor(bgr_, dst, cv::COLOR_BGR2YUV_YUYV);
+        return true;
+    }
+
+private:
+    cv::Mat bgr_;
+};
+
+#ifdef HAVE_LIBJPEG
+
+// ---------------------------------------------------------------------------
+// libjpeg(-turbo) decoder: SIMD IDCT, DCT-domain scaling and raw YCbCr output
+// ---------------------------------------------------------------------------
+
+struct JpegErrorManager {
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+};
+
+static void jpegErrorExit(j_common_ptr cinfo) {
+    longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+}
+
+static void jpegOutputMessage(j_common_ptr) {
+    // Webcams routinely emit slightly corrupt frames; don't spam the log
+}
+
+// JPEG scaled dimensions are ceil(size * num / 8)
+static int scaledSize(int size, int num) {
+    return (size * num + 7) / 8;
+}
+
+static int findScale(int srcW, int srcH, int dstW, int dstH) {
+    for (int num = 8; num >= 1; --num) {
+        if (scaledSize(srcW, num) == dstW && scaledSize(srcH, num) == dstH) {
+            return num;
+        }
+    }
+    return 0;
+}
+
+class LibjpegMjpegDecoder : public MjpegDecoder {
+public:
+    LibjpegMjpegDecoder() {
+        cinfo_.err = jpeg_std_error(&err_.pub);
+        err_.pub.error_exit = jpegErrorExit;
+        err_.pub.output_message = jpegOutputMessage;
+        jpeg_create_decompress(&cinfo_);
+
+        // JPEG is full-range YCbCr; the output is limited range
+        for (int v = 0; v < 256; ++v) {
+            lumaRange_[v] = static_cast<uint8_t>(16 + (v * 219 + 127) / 255);
+            chromaRange_[v] = static_cast<uint8_t>(128 + ((v - 128) * 224) / 255);
+        }
+    }
+
+    ~LibjpegMjpegDecoder() override {
+        jpeg_destroy_decompress(&cinfo_);
+    }
+
+    const char* name() const override { return "libjpeg"; }
+
+    bool decodeBGR(const uint8_t* data, size_t size, cv::Mat& dst) override {
+        if (setjmp(err_.jump)) {
+            jpeg_abort_decompress(&cinfo_);
+            return false;
+        }
+
+        jpeg_mem_src(&cinfo_, const_cast<unsigned char*>(data), size);
+        if (jpeg_read_header(&cinfo_, TRUE) != JPEG_HEADER_OK) {
+            jpeg_abort_decompress(&cinfo_);
+            return false;
+        }
+
+        cinfo_.out_color_space = JCS_EXT_BGR;
+        cinfo_.dct_method = JDCT_IFAST;
+        jpeg_start_decompress(&cinfo_);
+
+        dst.create(cinfo_.output_height, cinfo_.output_width, CV_8UC3);
+        while (cinfo_.output_scanline < cinfo_.output_height) {
+            JSAMPROW row = dst.ptr(cinfo_.output_scanline);
+            jpeg_read_scanlines(&cinfo_, &row, 1);
+        }
+
+        jpeg_finish_decompress(&cinfo_);
+        return true;
+    }
+
+    bool canDecodeYUYV(int srcW, int srcH, int dstW, int dstH) const override {
+        return findScale(srcW, srcH, dstW, dstH) > 0;
+    }
+
+    bool decodeYUYV(const uint8_t* data, size_t size, cv::Mat& dst) override {
+        if (setjmp(err_.jump)) {
+            jpeg_abort_decompress(&cinfo_);
+            return false;
+        }
+
+        jpeg_mem_src(&cinfo_, const_cast<unsigned char*>(data), size);
+        if (jpeg_read_header(&cinfo_, TRUE) != JPEG_HEADER_OK || cinfo_.num_components != 3) {
+            jpeg_abort_decompress(&cinfo_);
+            return false;
+        }
+
+        int num = findScale(cinfo_.image_width, cinfo_.image_height, dst.cols, dst.rows);
+        if (num == 0) {
+            jpeg_abort_decompress(&cinfo_);
+            return false;
+        }
+
+        // Skip colour conversion and upsampling: read the YCbCr planes as stored
+        cinfo_.scale_num = num;
+        cinfo_.scale_denom = 8;
+        cinfo_.out_color_space = JCS_YCbCr;
+        cinfo_.raw_data_out = TRUE;
+        cinfo_.do_fancy_upsampling = FALSE;
+        cinfo_.dct_method = JDCT_IFAST;
+        jpeg_start_decompress(&cinfo_);
+
+        const int width = cinfo_.output_width;
+        const int height = cinfo_.output_height;
+        if (width != dst.cols || height != dst.rows) {
+            jpeg_abort_decompress(&cinfo_);
+            return false;
+        }
+
+#if JPEG_LIB_VERSION >= 70
+        const int minScaled = cinfo_.min_DCT_v_scaled_size;
+#else
+        const int minScaled = cinfo_.min_DCT_scaled_size;
+#endif
+        const int rowsPerPass = cinfo_.max_v_samp_factor * minScaled;
+        if (rowsPerPass > MAX_ROWS) {
+            jpeg_abort_decompress(&cinfo_);
+            return false;
+        }
+
+        JSAMPARRAY planes[3];
+        int compRows[3];
+        for (int c = 0; c < 3; ++c) {
+            const jpeg_component_info& comp = cinfo_.comp_info[c];
+#if JPEG_LIB_VERSION >= 70
+            const int scaled = comp.DCT_v_scaled_size;
+            const int hScaled = comp.DCT_h_scaled_size;
+#else
+            const int scaled = comp.DCT_scaled_size;
+            const int hScaled = comp.DCT_scaled_size;
+#endif
+            compRows[c] = comp.v_samp_factor * scaled;
+            const size_t stride = static_cast<size_t>(comp.width_in_blocks) * hScaled;
+            plane_[c].resize(stride * compRows[c]);
+            for (int r = 0; r < compRows[c]; ++r) {
+                rows_[c][r] = plane_[c].data() + r * stride;
+            }
+            planes[c] = rows_[c].data();
+
+            // Output pixel x -> sample index within this component's row
+            colMap_[c].resize(width);
+            for (int x = 0; x < width; ++x) {
+                colMap_[c][x] = x * comp.h_samp_factor / cinfo_.max_h_samp_factor;
+            }
+        }
+
+        while (cinfo_.output_scanline < static_cast<JDIMENSION>(height)) {
+            const int baseY = cinfo_.output_scanline;
+            jpeg_read_raw_data(&cinfo_, planes, rowsPerPass);
+
+            for (int r = 0; r < rowsPerPass && baseY + r < height; ++r) {
+                const uint8_t* yRow = rows_[0][r * compRows[0] / rowsPerPass];
+                const uint8_t* uRow = rows_[1][r * compRows[1] / rowsPerPass];
+                const uint8_t* vRow = rows_[2][r * compRows[2] / rowsPerPass];
+                packRow(yRow, uRow, vRow, dst.ptr(baseY + r), width);
+            }
+        }
+
+        jpeg_finish_decompress(&cinfo_);
+        cinfo_.raw_data_out = FALSE;
+        return true;
+    }
+
+private:
+    static constexpr int MAX_ROWS = 64;
+
+    void packRow(const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow, uint8_t* out, int width) const {
+        const int* yMap = colMap_[0].data();
+        const int* uMap = colMap_[1].data();
+        const int* vMap = colMap_[2].data();
+        for (int x = 0; x + 1 < width; x += 2) {
+            out[0] = lumaRange_[yRow[yMap[x]]];
+            out[1] = chromaRange_[uRow[uMap[x]]];
+            out[2] = lumaRange_[yRow[yMap[x + 1]]];
+            out[3] = chromaRange_[vRow[vMap[x]]];
+            out += 4;
+        }
+    }
+
+    jpeg_decompress_struct cinfo_{};
+    JpegErrorManager err_{};
+
+    std::vector<uint8_t> plane_[3];
+    std::array<JSAMPROW, MAX_ROWS> rows_[3]{};
+    std::vector<int> colMap_[3];
+    uint8_t lumaRange_[256];
+    uint8_t chromaRange_[256];
+};
+
+#endif  // HAVE_LIBJPEG
+
+std::unique_ptr<MjpegDecoder> createMjpegDecoder(MjpegDecoderType type) {
+#ifdef HAVE_LIBJPEG
+    if (type == MjpegDecoderType::AUTO || type == MjpegDecoderType::LIBJPEG) {
+        return std::make_unique<LibjpegMjpegDecoder>();
+    }
+#else
+    if (type == MjpegDecoderType::LIBJPEG) {
+        std::cerr << "Warning: built without libjpeg, using OpenCV MJPEG decoder" << std::endl;
+    }
+#endif
+    return std::make_unique<OpenCVMjpegDecoder>();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <cstdint>
+#include "config.h"
+
+// Decoder stage for compressed (MJPEG) camera frames. One instance is created
+// per open camera and reuses its scratch buffers between frames.
+class MjpegDecoder {
+public:
+    virtual ~MjpegDecoder() = default;
+
+    virtual const char* name() const = 0;
+
+    // Full-size decode to BGR; dst is reallocated only when the size changes
+    virtual bool decodeBGR(const uint8_t* data, size_t size, cv::Mat& dst) = 0;
+
+    // Whether decodeYUYV() can produce exactly dstW x dstH from a
+    // srcW x srcH stream (directly or through DCT-domain downscaling)
+    virtual bool canDecodeYUYV(int srcW, int srcH, int dstW, int dstH) const = 0;
+
+    // Decode straight into a preallocated CV_8UC2 YUYV frame (limited range,
+    // like cv::COLOR_BGR2YUV_YUYV) with no BGR intermediate
+    virtual bool decodeYUYV(const uint8_t* data, size_t size, cv::Mat& dst) = 0;
+};
+
+// AUTO picks libjpeg(-turbo) when built with it, otherwise OpenCV
+std::unique_ptr<MjpegDecoder> createMjpegDecoder(MjpegDecoderType type);
@@ -0,0 +1,69 @@
+#include "output_thread.h"
+#include "stage_stats.h"
+
+// Wake up this often to notice stop()
+static constexpr int OUTPUT_POLL_MS = 100;
+
+OutputThread::OutputThread(FrameSink& output, int depth)
+    : output_(output), ring_(depth) {}
+
+OutputThread::~OutputThread() {
+    stop();
+}
+
+void OutputThread::start() {
+    stop();
+    ring_.reset();
+    stop_.store(false);
+    thread_ = std::thread(&OutputThread::run, this);
+}
+
+void OutputThread::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    stop_.store(true);
+    ring_.notify();
+    thread_.join();
+}
+
+void OutputThread::run() {
+    applyPlacement("output", placement_);
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        cv::Mat* frame = ring_.acquireRead(OUTPUT_POLL_MS);
+        if (frame) {
+            output_.writeFrameYUYV(*frame);
+        }
+    }
+    ring_.releaseRead();
+}
+
+cv::Mat& OutputThread::acquireBuffer() {
+    cv::Mat& frame = ring_.acquireWrite();
+    frame.create(output_.getHeight(), output_.getWidth(), CV_8UC2);
+    return frame;
+}
+
+void OutputThread::commitBuffer() {
+    ring_.publish();
+}
+
+void OutputThread::writeFrame(const cv::Mat& frame) {
+    if (frame.empty()) {
+        return;
+    }
+
+    StageTimer timer(Stage::CONVERT);
+    scaler_.toYUYV(frame, acquireBuffer());
+    commitBuffer();
+}
+
+void OutputThread::writeFrameYUYV(const cv::Mat& yuyv) {
+    if (yuyv.empty() || yuyv.cols != getWidth() || yuyv.rows != getHeight()) {
+        return;
+    }
+
+    yuyv.copyTo(acquireBuffer());
+    commitBuffer();
+}
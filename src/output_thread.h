@@ -0,0 +1,44 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <thread>
+#include "frame_ring.h"
+#include "thread_placement.h"
+#include "frame_sink.h"
+
+// Output stage of the pipeline: the render loop fills YUYV frames in a ring
+// and this thread writes them to the real sink (virtual camera, file, shared
+// memory), so a slow write() or DQBUF never stalls rendering. When the ring is full the oldest queued
+// frame is dropped.
+class OutputThread : public FrameSink {
+public:
+    OutputThread(FrameSink& output, int depth);
+    ~OutputThread() override;
+
+    // output must be open and only used through this object until stop()
+    void start();
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+    void setPlacement(const ThreadPlacement& placement) { placement_ = placement; }  // From the next start()
+
+    int getWidth() const override { return output_.getWidth(); }
+    int getHeight() const override { return output_.getHeight(); }
+
+    // Scaling and colour conversion run here, on the caller's thread
+    void writeFrame(const cv::Mat& frame) override;
+    void writeFrameYUYV(const cv::Mat& yuyv) override;
+    cv::Mat& acquireBuffer() override;
+    void commitBuffer() override;
+
+    uint64_t getDropped() const { return ring_.getDropped(); }
+
+private:
+    void run();
+
+    FrameSink& output_;
+    FrameRing<cv::Mat> ring_;
+    ThreadPlacement placement_;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+};
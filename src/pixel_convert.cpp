@@ -0,0 +1,194 @@
+#include "pixel_convert.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define STATIC_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define STATIC_NEON 1
+#endif
+
+// Gray level to luma: Y = 16 + v * 219 / 255 (chroma is neutral for gray)
+static const std::array<uint8_t, 256>& grayToLumaTable() {
+    static const std::array<uint8_t, 256> table = [] {
+        std::array<uint8_t, 256> t{};
+        for (int v = 0; v < 256; ++v) {
+            t[v] = static_cast<uint8_t>(16 + (v * 219 + 127) / 255);
+        }
+        return t;
+    }();
+    return table;
+}
+
+void grayRowToYUYV(const uint8_t* src, uint8_t* dst, int pixels) {
+    const auto& luma = grayToLumaTable();
+    for (int x = 0; x < pixels; ++x) {
+        dst[x * 2] = luma[src[x]];
+        dst[x * 2 + 1] = 128;
+    }
+}
+
+// One-row headers over the caller's memory, so OpenCV's vectorized
+// conversions run in place without allocating
+void bgrRowToYUYV(const uint8_t* src, uint8_t* dst, int pixels) {
+    cv::Mat in(1, pixels, CV_8UC3, const_cast<uint8_t*>(src));
+    cv::Mat out(1, pixels, CV_8UC2, dst);
+    cv::cvtColor(in, out, cv::COLOR_BGR2YUV_YUYV);
+}
+
+void bgrRowToGray(const uint8_t* src, uint8_t* dst, int pixels) {
+    cv::Mat in(1, pixels, CV_8UC3, const_cast<uint8_t*>(src));
+    cv::Mat out(1, pixels, CV_8UC1, dst);
+    cv::cvtColor(in, out, cv::COLOR_BGR2GRAY);
+}
+
+void bgrToYUYVColumns(const cv::Mat& src, cv::Mat& dst, int x0, int x1) {
+    int width = std::min(src.cols, dst.cols) & ~1;
+    x0 = std::max(0, x0 & ~1);
+    x1 = std::min(width, (x1 + 1) & ~1);
+    if (x0 >= x1) return;
+
+    cv::Rect roi(x0, 0, x1 - x0, std::min(src.rows, dst.rows));
+    cv::Mat dstRoi = dst(roi);
+    cv::cvtColor(src(roi), dstRoi, cv::COLOR_BGR2YUV_YUYV);
+}
+
+// BT.601: full range for gray, limited range for YUYV like cvtColor
+void ColorPalette::set(int index, uint8_t b, uint8_t g, uint8_t r) {
+    bgr[index * 3] = b;
+    bgr[index * 3 + 1] = g;
+    bgr[index * 3 + 2] = r;
+    gray[index] = static_cast<uint8_t>(std::lround(0.299 * r + 0.587 * g + 0.114 * b));
+    y[index] = static_cast<uint8_t>(std::lround(16.0 + (65.481 * r + 128.553 * g + 24.966 * b) / 255.0));
+    u[index] = static_cast<uint8_t>(std::lround(128.0 + (-37.797 * r - 74.203 * g + 112.0 * b) / 255.0));
+    v[index] = static_cast<uint8_t>(std::lround(128.0 + (112.0 * r - 93.786 * g - 18.214 * b) / 255.0));
+}
+
+void paletteRowToBGR(const uint8_t* src, uint8_t* dst, int pixels, const ColorPalette& palette) {
+    for (int x = 0; x < pixels; ++x, dst += 3) {
+        const uint8_t* c = &palette.bgr[src[x] * 3];
+        dst[0] = c[0];
+        dst[1] = c[1];
+        dst[2] = c[2];
+    }
+}
+
+void paletteRowToYUYV(const uint8_t* src, uint8_t* dst, int pixels, const ColorPalette& palette) {
+    for (int x = 0; x + 1 < pixels; x += 2, dst += 4) {
+        int a = src[x];
+        int b = src[x + 1];
+        dst[0] = palette.y[a];
+        dst[1] = static_cast<uint8_t>((palette.u[a] + palette.u[b] + 1) >> 1);
+        dst[2] = palette.y[b];
+        dst[3] = static_cast<uint8_t>((palette.v[a] + palette.v[b] + 1) >> 1);
+    }
+}
+
+void paletteRowToGray(const uint8_t* src, uint8_t* dst, int pixels, const ColorPalette& palette) {
+    for (int x = 0; x < pixels; ++x) {
+        dst[x] = palette.gray[src[x]];
+    }
+}
+
+void paletteToYUYVColumns(const cv::Mat& src, cv::Mat& dst, int x0, int x1, const ColorPalette& palette) {
+    int width = std::min(src.cols, dst.cols) & ~1;
+    x0 = std::max(0, x0 & ~1);
+    x1 = std::min(width, (x1 + 1) & ~1);
+    int rows = std::min(src.rows, dst.rows);
+    for (int y = 0; y < rows; ++y) {
+        paletteRowToYUYV(src.ptr(y) + x0, dst.ptr(y) + x0 * 2, x1 - x0, palette);
+    }
+}
+
+// (v + 1 + (v >> 8)) >> 8 equals v / 255 for every product of two bytes
+static inline int shadeStaticPixel(int tile, int bright, int bandShift, int bandAdd, int scale) {
+    int v = tile * bright;
+    v = (v + 1 + (v >> 8)) >> 8;
+    v = std::min(255, (v >> bandShift) + bandAdd);
+    return (v * scale) >> 8;
+}
+
+#if STATIC_SSE2
+
+// 8 pixels in 16-bit lanes; every intermediate stays below 65536
+static inline __m128i shadeStatic8(const uint8_t* tile, const uint8_t* bright,
+                                   __m128i shift, __m128i add, __m128i scale) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i max = _mm_set1_epi16(255);
+    __m128i t = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(tile)), zero);
+    __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bright)), zero);
+    __m128i v = _mm_mullo_epi16(t, b);
+    v = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, one), _mm_srli_epi16(v, 8)), 8);
+    v = _mm_min_epi16(_mm_add_epi16(_mm_srl_epi16(v, shift), add), max);
+    return _mm_srli_epi16(_mm_mullo_epi16(v, scale), 8);
+}
+
+#elif STATIC_NEON
+
+static inline uint16x8_t shadeStatic8(const uint8_t* tile, const uint8_t* bright,
+                                      int16x8_t shift, uint16x8_t add, uint16x8_t scale) {
+    uint16x8_t v = vmull_u8(vld1_u8(tile), vld1_u8(bright));
+    v = vshrq_n_u16(vaddq_u16(vaddq_u16(v, vdupq_n_u16(1)), vshrq_n_u16(v, 8)), 8);
+    v = vminq_u16(vaddq_u16(vshlq_u16(v, shift), add), vdupq_n_u16(255));
+    return vshrq_n_u16(vmulq_u16(v, scale), 8);
+}
+
+#endif
+
+void shadeStaticRowGray(uint8_t* dst, const uint8_t* tile, const uint8_t* bright, int pixels,
+                        int bandShift, int bandAdd, int scale) {
+    int x = 0;
+#if STATIC_SSE2
+    const __m128i shift = _mm_cvtsi32_si128(bandShift);
+    const __m128i add = _mm_set1_epi16(static_cast<short>(bandAdd));
+    const __m128i mul = _mm_set1_epi16(static_cast<short>(scale));
+    for (; pixels - x >= 8; x += 8) {
+        __m128i v = shadeStatic8(tile + x, bright + x, shift, add, mul);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(v, v));
+    }
+#elif STATIC_NEON
+    const int16x8_t shift = vdupq_n_s16(static_cast<int16_t>(-bandShift));
+    const uint16x8_t add = vdupq_n_u16(static_cast<uint16_t>(bandAdd));
+    const uint16x8_t mul = vdupq_n_u16(static_cast<uint16_t>(scale));
+    for (; pixels - x >= 8; x += 8) {
+        vst1_u8(dst + x, vmovn_u16(shadeStatic8(tile + x, bright + x, shift, add, mul)));
+    }
+#endif
+    for (; x < pixels; ++x) {
+        dst[x] = static_cast<uint8_t>(shadeStaticPixel(tile[x], bright[x], bandShift, bandAdd, scale));
+    }
+}
+
+void shadeStaticRowYUYV(uint8_t* dst, const uint8_t* tile, const uint8_t* bright, int pixels,
+                        int bandShift, int bandAdd, int scale) {
+    int x = 0;
+#if STATIC_SSE2
+    // Luma in the low byte of each 16-bit lane, chroma 128 in the high byte
+    const __m128i shift = _mm_cvtsi32_si128(bandShift);
+    const __m128i add = _mm_set1_epi16(static_cast<short>(bandAdd));
+    const __m128i mul = _mm_set1_epi16(static_cast<short>(scale));
+    const __m128i chroma = _mm_set1_epi16(static_cast<short>((128 << 8) | 16));
+    for (; pixels - x >= 8; x += 8) {
+        __m128i v = shadeStatic8(tile + x, bright + x, shift, add, mul);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2), _mm_add_epi16(v, chroma));
+    }
+#elif STATIC_NEON
+    const int16x8_t shift = vdupq_n_s16(static_cast<int16_t>(-bandShift));
+    const uint16x8_t add = vdupq_n_u16(static_cast<uint16_t>(bandAdd));
+    const uint16x8_t mul = vdupq_n_u16(static_cast<uint16_t>(scale));
+    for (; pixels - x >= 8; x += 8) {
+        uint8x8x2_t out;
+        out.val[0] = vadd_u8(vmovn_u16(shadeStatic8(tile + x, bright + x, shift, add, mul)), vdup_n_u8(16));
+        out.val[1] = vdup_n_u8(128);
+        vst2_u8(dst + x * 2, out);
+    }
+#endif
+    for (; x < pixels; ++x) {
+        dst[x * 2] = static_cast<uint8_t>(16 + shadeStaticPixel(tile[x], bright[x], bandShift, bandAdd, scale));
+        dst[x * 2 + 1] = 128;
+    }
+}
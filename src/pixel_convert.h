@@ -0,0 +1,47 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+// Direct-to-YUYV helpers for effects whose pixels are grayscale, so they can
+// fill the output buffer without a BGR intermediate or a cvtColor pass.
+// Values use BT.601 limited range, matching cv::COLOR_BGR2YUV_YUYV.
+
+// Convert the column range [x0, x1) of a BGR frame into the matching range of
+// a YUYV frame. The range is widened to even bounds so pixel pairs stay whole.
+void bgrToYUYVColumns(const cv::Mat& src, cv::Mat& dst, int x0, int x1);
+
+// Single-row conversions for effect kernels; pixels must be even for YUYV
+void grayRowToYUYV(const uint8_t* src, uint8_t* dst, int pixels);
+void bgrRowToYUYV(const uint8_t* src, uint8_t* dst, int pixels);
+void bgrRowToGray(const uint8_t* src, uint8_t* dst, int pixels);
+
+// 256-entry colour table for single-channel palette-indexed layers. Output
+// values for every format are precomputed, so colouring a pixel is a lookup.
+struct ColorPalette {
+    uint8_t bgr[256 * 3] = {};
+    uint8_t gray[256] = {};
+    uint8_t y[256] = {};
+    uint8_t u[256] = {};
+    uint8_t v[256] = {};
+
+    void set(int index, uint8_t b, uint8_t g, uint8_t r);
+};
+
+// Palette index rows to each format; YUYV chroma is the mean of each pair
+void paletteRowToBGR(const uint8_t* src, uint8_t* dst, int pixels, const ColorPalette& palette);
+void paletteRowToYUYV(const uint8_t* src, uint8_t* dst, int pixels, const ColorPalette& palette);
+void paletteRowToGray(const uint8_t* src, uint8_t* dst, int pixels, const ColorPalette& palette);
+
+// bgrToYUYVColumns for a palette index frame
+void paletteToYUYVColumns(const cv::Mat& src, cv::Mat& dst, int x0, int x1, const ColorPalette& palette);
+
+// Shade one row of glyph-tile static. Each pixel is tile * bright / 255, then
+// halved (bandShift = 1) and/or raised by bandAdd with saturation for TV
+// bands, then multiplied by scale / 256 (scanlines). The YUYV variant also adds
+// the 16 luma offset and writes neutral chroma, so fold 219/255 into scale.
+// SSE2 or NEON when the build targets them, scalar otherwise.
+void shadeStaticRowGray(uint8_t* dst, const uint8_t* tile, const uint8_t* bright, int pixels,
+                        int bandShift, int bandAdd, int scale);
+void shadeStaticRowYUYV(uint8_t* dst, const uint8_t* tile, const uint8_t* bright, int pixels,
+                        int bandShift, int bandAdd, int scale);
@@ -0,0 +1,115 @@
+#include "shm_sink.h"
+#include "stage_stats.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static constexpr size_t PAGE_SIZE = 4096;
+static const char SHM_MAGIC[8] = {'M', 'F', 'S', 'H', 'M', 'R', 'N', 'G'};
+
+ShmSink::~ShmSink() {
+    close();
+}
+
+bool ShmSink::open(const std::string& name, int width, int height, int slotCount) {
+    close();
+    if (slotCount < 3) slotCount = 3;  // Readers need a slot of slack
+
+    name_ = name.empty() || name[0] != '/' ? "/" + name : name;
+    width_ = width;
+    height_ = height;
+    frameSize_ = static_cast<size_t>(width) * height * 2;
+    const size_t dataOffset = (sizeof(ShmRingHeader) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    mapSize_ = dataOffset + frameSize_ * slotCount;
+
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared memory " << name_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(mapSize_)) != 0) {
+        std::cerr << "Failed to size shared memory " << name_ << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    map_ = mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory " << name_ << ": " << strerror(errno) << std::endl;
+        map_ = nullptr;
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    // Fresh segment is zeroed, so readers see sequence 0 until the first frame
+    header_ = new (map_) ShmRingHeader{};
+    header_->version = VERSION;
+    header_->width = width;
+    header_->height = height;
+    header_->fourcc = 'Y' | ('U' << 8) | ('Y' << 16) | (static_cast<uint32_t>('V') << 24);
+    header_->frameSize = static_cast<uint32_t>(frameSize_);
+    header_->slotCount = slotCount;
+    header_->dataOffset = dataOffset;
+    slots_ = static_cast<uint8_t*>(map_) + dataOffset;
+    // Magic last: a reader that sees it also sees the fields above
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, SHM_MAGIC, sizeof(SHM_MAGIC));
+    return true;
+}
+
+void ShmSink::close() {
+    if (map_) {
+        munmap(map_, mapSize_);
+        shm_unlink(name_.c_str());
+    }
+    map_ = nullptr;
+    header_ = nullptr;
+    slots_ = nullptr;
+    slot_.release();
+}
+
+cv::Mat& ShmSink::acquireBuffer() {
+    if (!header_) {
+        slot_.create(height_, width_, CV_8UC2);  // Nowhere to publish; keep callers safe
+        return slot_;
+    }
+    uint64_t seq = header_->sequence.load(std::memory_order_relaxed);
+    uint8_t* data = slots_ + (seq % header_->slotCount) * frameSize_;
+    slot_ = cv::Mat(height_, width_, CV_8UC2, data);
+    return slot_;
+}
+
+void ShmSink::commitBuffer() {
+    if (!header_) {
+        return;
+    }
+    StageTimer timer(Stage::WRITE);
+    header_->sequence.fetch_add(1, std::memory_order_release);
+    StageStats::instance().add(Counter::FRAMES);
+}
+
+void ShmSink::writeFrame(const cv::Mat& frame) {
+    if (!header_ || frame.empty()) {
+        return;
+    }
+
+    {
+        StageTimer timer(Stage::CONVERT);
+        scaler_.toYUYV(frame, acquireBuffer());
+    }
+    commitBuffer();
+}
+
+void ShmSink::writeFrameYUYV(const cv::Mat& yuyv) {
+    if (!header_ || yuyv.empty() || yuyv.cols != width_ || yuyv.rows != height_ || yuyv.type() != CV_8UC2) {
+        return;
+    }
+    yuyv.copyTo(acquireBuffer());
+    commitBuffer();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include "frame_sink.h"
+
+// Layout of the shared-memory ring at the start of the segment. Slot i holds
+// a packed YUYV frame at dataOffset + i * frameSize; the newest is slot
+// (sequence - 1) % slotCount. A reader loads sequence (s1), copies that slot,
+// loads sequence again (s2) and keeps the copy only if s2 - s1 < slotCount - 1,
+// since the writer may have come round and overwritten it otherwise.
+struct ShmRingHeader {
+    char magic[8];                  // "MFSHMRNG"
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t fourcc;                // 'YUYV'
+    uint32_t frameSize;             // Bytes per slot
+    uint32_t slotCount;
+    uint64_t dataOffset;            // Page aligned
+    std::atomic<uint64_t> sequence; // Frames published so far
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared ring needs a lock-free counter");
+
+// Headless sink publishing frames into a POSIX shared-memory ring
+// (/dev/shm/<name>) for readers in other processes. The writer never waits
+// for readers; slow ones skip frames.
+class ShmSink : public FrameSink {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    ShmSink() = default;
+    ~ShmSink() override;
+
+    ShmSink(const ShmSink&) = delete;
+    ShmSink& operator=(const ShmSink&) = delete;
+
+    // Replaces an existing segment of the same name; removed again on close()
+    bool open(const std::string& name, int width, int height, int slotCount = 4);
+    void close();
+    bool isOpened() const { return header_ != nullptr; }
+
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+
+    void writeFrame(const cv::Mat& frame) override;
+    void writeFrameYUYV(const cv::Mat& yuyv) override;
+    cv::Mat& acquireBuffer() override;
+    void commitBuffer() override;
+
+private:
+    std::string name_;
+    void* map_ = nullptr;
+    size_t mapSize_ = 0;
+    ShmRingHeader* header_ = nullptr;
+    uint8_t* slots_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+    size_t frameSize_ = 0;
+
+    cv::Mat slot_;                  // View of the slot being written
+};
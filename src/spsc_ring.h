@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <type_traits>
+
+// Bounded lock-free queue for one producer and one consumer thread, holding
+// small trivially copyable values (frame slot indices). Besides the consumer,
+// the producer may also pop(): that is how it discards the oldest entry when
+// the consumer falls behind. Both sides claim the head with a CAS, so a pop
+// never returns an entry the other side already took.
+template <typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing holds plain values");
+
+public:
+    explicit SpscRing(size_t minCapacity) {
+        capacity_ = 1;
+        while (capacity_ < minCapacity) capacity_ <<= 1;
+        mask_ = capacity_ - 1;
+        slots_.reset(new std::atomic<T>[capacity_]);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only. Fails when full.
+    bool push(T value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= capacity_) {
+            return false;
+        }
+        slots_[tail & mask_].store(value, std::memory_order_relaxed);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer, or producer dropping the oldest entry. Fails when empty.
+    bool pop(T& value) {
+        size_t head = head_.load(std::memory_order_acquire);
+        while (head != tail_.load(std::memory_order_acquire)) {
+            value = slots_[head & mask_].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Approximate from the consumer's side, exact from the producer's
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+    std::unique_ptr<std::atomic<T>[]> slots_;
+
+    // Separate cache lines so the two threads don't false-share
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
@@ -0,0 +1,163 @@
+#include "stage_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+// Buckets 0-3 hold 0-3 ns exactly; above that each power of two [2^e, 2^(e+1))
+// is split into four equal sub-buckets
+static int bucketFor(uint64_t ns) {
+    if (ns < 4) {
+        return static_cast<int>(ns);
+    }
+    int e = 63 - __builtin_clzll(ns);
+    int sub = static_cast<int>((ns >> (e - 2)) & 3);
+    return std::min(LatencyHistogram::BUCKETS - 1, 4 * (e - 1) + sub);
+}
+
+static uint64_t bucketValue(int index) {
+    if (index < 4) {
+        return index;
+    }
+    int e = index / 4 + 1;
+    uint64_t width = uint64_t(1) << (e - 2);
+    return (4 + index % 4) * width + width / 2;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    counts_[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+    sumNs_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t prev = max_.load(std::memory_order_relaxed);
+    while (ns > prev && !max_.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::snapshot(Counts& counts) const {
+    for (int i = 0; i < BUCKETS; ++i) {
+        counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyHistogram::quantile(const Counts& counts, double q) {
+    uint64_t total = 0;
+    for (uint64_t c : counts) total += c;
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * total)));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return bucketValue(i);
+        }
+    }
+    return bucketValue(BUCKETS - 1);
+}
+
+StageStats& StageStats::instance() {
+    static StageStats stats;
+    return stats;
+}
+
+const char* StageStats::stageName(Stage stage) {
+    switch (stage) {
+        case Stage::CAPTURE: return "capture";
+        case Stage::DECODE:  return "decode";
+        case Stage::RENDER:  return "render";
+        case Stage::CONVERT: return "convert";
+        case Stage::WRITE:   return "write";
+        case Stage::FRAME:   return "frame";
+        default:             return "unknown";
+    }
+}
+
+const char* StageStats::counterName(Counter counter) {
+    switch (counter) {
+        case Counter::FRAMES:           return "frames";
+        case Counter::WRITE_ERRORS:     return "write_errors";
+        case Counter::CAPTURE_DROPS:    return "capture_drops";
+        case Counter::OUTPUT_DROPS:     return "output_drops";
+        case Counter::MISSED_DEADLINES: return "missed_deadlines";
+        default:                        return "unknown";
+    }
+}
+
+// "850us", "12.3ms"
+static std::string formatNs(uint64_t ns) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    if (ns < 1000000) {
+        out << ns / 1000.0 << "us";
+    } else {
+        out << ns / 1000000.0 << "ms";
+    }
+    return out.str();
+}
+
+std::string StageStats::formatInterval(double seconds) {
+    uint64_t deltas[COUNTERS];
+    for (int i = 0; i < COUNTERS; ++i) {
+        uint64_t value = counters_[i].load(std::memory_order_relaxed);
+        deltas[i] = value - lastCounters_[i];
+        lastCounters_[i] = value;
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "Stats: " << (seconds > 0 ? deltas[static_cast<int>(Counter::FRAMES)] / seconds : 0.0) << " fps";
+    for (int i = static_cast<int>(Counter::WRITE_ERRORS); i < COUNTERS; ++i) {
+        if (deltas[i]) {
+            out << ", " << deltas[i] << " " << counterName(static_cast<Counter>(i));
+        }
+    }
+
+    LatencyHistogram::Counts counts;
+    for (int s = 0; s < STAGES; ++s) {
+        histograms_[s].snapshot(counts);
+        uint64_t maxNs = histograms_[s].takeMax();
+        uint64_t n = 0;
+        for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            uint64_t current = counts[i];
+            counts[i] -= lastCounts_[s][i];
+            lastCounts_[s][i] = current;
+            n += counts[i];
+        }
+        if (n == 0) continue;
+
+        out << " | " << stageName(static_cast<Stage>(s))
+            << " p50 " << formatNs(LatencyHistogram::quantile(counts, 0.5))
+            << " p99 " << formatNs(LatencyHistogram::quantile(counts, 0.99))
+            << " max " << formatNs(maxNs);
+    }
+    return out.str();
+}
+
+std::string StageStats::formatPrometheus() const {
+    std::ostringstream out;
+    out << "# HELP matrix_filter_stage_seconds Time spent per pipeline stage\n"
+        << "# TYPE matrix_filter_stage_seconds summary\n";
+
+    LatencyHistogram::Counts counts;
+    for (int s = 0; s < STAGES; ++s) {
+        histograms_[s].snapshot(counts);
+        uint64_t n = 0;
+        for (uint64_t c : counts) n += c;
+        const char* name = stageName(static_cast<Stage>(s));
+
+        for (double q : {0.5, 0.9, 0.99}) {
+            out << "matrix_filter_stage_seconds{stage=\"" << name << "\",quantile=\"" << q << "\"} "
+                << LatencyHistogram::quantile(counts, q) / 1e9 << "\n";
+        }
+        out << "matrix_filter_stage_seconds_sum{stage=\"" << name << "\"} "
+            << histograms_[s].getSum() / 1e9 << "\n"
+            << "matrix_filter_stage_seconds_count{stage=\"" << name << "\"} " << n << "\n";
+    }
+
+    for (int i = 0; i < COUNTERS; ++i) {
+        const char* name = counterName(static_cast<Counter>(i));
+        out << "# TYPE matrix_filter_" << name << "_total counter\n"
+            << "matrix_filter_" << name << "_total " << counters_[i].load(std::memory_order_relaxed) << "\n";
+    }
+    return out.str();
+}
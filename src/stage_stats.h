@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Pipeline stages timed by StageTimer
+enum class Stage {
+    CAPTURE,    // Waiting for / dequeuing a camera frame
+    DECODE,     // Camera frame to BGR or YUYV (MJPEG, cvtColor)
+    RENDER,     // Effect update and render
+    CONVERT,    // Scaling and BGR to YUYV for the output
+    WRITE,      // Handing a frame to the virtual camera
+    FRAME,      // One main loop iteration, without pacing sleep
+    COUNT
+};
+
+enum class Counter {
+    FRAMES,             // Frames handed to the virtual camera
+    WRITE_ERRORS,
+    CAPTURE_DROPS,      // Set from the pipeline rings
+    OUTPUT_DROPS,
+    MISSED_DEADLINES,   // Set from the frame scheduler
+    COUNT
+};
+
+// Latency histogram over power-of-two buckets split four ways, so quantiles
+// are within ~12%. record() is a few relaxed atomic ops, safe from any thread.
+class LatencyHistogram {
+public:
+    static constexpr int BUCKETS = 160;     // Up to ~2^40 ns, i.e. minutes
+    using Counts = std::array<uint64_t, BUCKETS>;
+
+    void record(uint64_t ns);
+    void snapshot(Counts& counts) const;
+    uint64_t getSum() const { return sumNs_.load(std::memory_order_relaxed); }
+    uint64_t takeMax() { return max_.exchange(0, std::memory_order_relaxed); }
+
+    // Value at quantile q (0..1) of the given counts, in ns; 0 if empty
+    static uint64_t quantile(const Counts& counts, double q);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+    std::atomic<uint64_t> sumNs_{0};
+    std::atomic<uint64_t> max_{0};          // Since the last takeMax()
+};
+
+// Process-wide stage histograms and counters. Recording is lock-free;
+// formatInterval() keeps the previous snapshot, so call it from one thread.
+class StageStats {
+public:
+    static StageStats& instance();
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+    void record(Stage stage, uint64_t ns) { histograms_[static_cast<int>(stage)].record(ns); }
+    void add(Counter counter, uint64_t n = 1) {
+        counters_[static_cast<int>(counter)].fetch_add(n, std::memory_order_relaxed);
+    }
+    void set(Counter counter, uint64_t value) {
+        counters_[static_cast<int>(counter)].store(value, std::memory_order_relaxed);
+    }
+
+    // One line with p50/p99/max per stage and counter deltas since the last call
+    std::string formatInterval(double seconds);
+
+    // Prometheus text exposition of everything since startup
+    std::string formatPrometheus() const;
+
+    static const char* stageName(Stage stage);
+    static const char* counterName(Counter counter);
+
+private:
+    static constexpr int STAGES = static_cast<int>(Stage::COUNT);
+    static constexpr int COUNTERS = static_cast<int>(Counter::COUNT);
+
+    static inline std::atomic<bool> enabled_{false};
+
+    LatencyHistogram histograms_[STAGES];
+    std::atomic<uint64_t> counters_[COUNTERS] = {};
+
+    // Snapshot at the previous formatInterval()
+    LatencyHistogram::Counts lastCounts_[STAGES] = {};
+    uint64_t lastCounters_[COUNTERS] = {};
+};
+
+// Times its scope into a stage; does nothing while stats are disabled
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage) : stage_(stage), start_(StageStats::enabled() ? now() : 0) {}
+    ~StageTimer() {
+        if (start_) {
+            StageStats::instance().record(stage_, now() - start_);
+        }
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    Stage stage_;
+    uint64_t start_;
+};
@@ -1,16 +1,37 @@
 #include "static_effect.h"
-#include <random>
+#include "pixel_convert.h"
+#include "thread_pool.h"
+#include "thread_placement.h"
+#include "glyph_bitmap.h"
+#include "effect_kernels.h"
+#include "fast_rng.h"
 #include <iostream>
 #include <filesystem>
 #include <chrono>
-#include <fstream>
 #include <sstream>
-#include <iomanip>
-
-static std::mt19937 rng(std::random_device{}());
-
-// Cache directory base path
-static const std::string CACHE_BASE = "/tmp/matrix-filter-static";
+#include <atomic>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// One file per resolution: header, then CACHE_SIZE grayscale frames for each
+// char size from MIN_CHAR_SIZE to MAX_CHAR_SIZE, starting at a page boundary
+static const char CACHE_MAGIC[8] = {'M', 'F', 'S', 'T', 'A', 'T', 'I', 'C'};
+static constexpr uint32_t CACHE_VERSION = 1;
+static constexpr size_t CACHE_DATA_OFFSET = 4096;
+
+struct StaticCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frameCount;        // Per char size
+    uint32_t minCharSize;
+    uint32_t maxCharSize;
+};
 
 // Font paths to try
 static const char* fontPaths[] = {
@@ -27,20 +48,62 @@ static uint64_t getCurrentTimeMs() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
 }
 
+static std::vector<GlyphBitmap> rasterizeGlyphs(FT_Face face, const std::vector<wchar_t>& chars, int size) {
+    std::vector<GlyphBitmap> glyphs;
+    glyphs.reserve(chars.size());
+    FT_Set_Pixel_Sizes(face, 0, size);
+    for (wchar_t ch : chars) {
+        GlyphBitmap glyph;
+        FT_UInt glyphIndex = FT_Get_Char_Index(face, ch);
+        if (FT_Load_Glyph(face, glyphIndex, FT_LOAD_RENDER) == 0) {
+            FT_Bitmap& bitmap = face->glyph->bitmap;
+            if (bitmap.rows > 0 && bitmap.width > 0) {
+                cv::Mat view(bitmap.rows, bitmap.width, CV_8UC1, bitmap.buffer, bitmap.pitch);
+                glyph.alpha = view.clone();
+            }
+            glyph.left = face->glyph->bitmap_left;
+            glyph.top = face->glyph->bitmap_top;
+        }
+        glyphs.push_back(glyph);
+    }
+    return glyphs;
+}
+
+// Everything the workers need, owned jointly with them so a build can be
+// abandoned (resolution change, shutdown) while jobs are still running
+struct StaticEffect::CacheBuild {
+    int width = 0;
+    int height = 0;
+    uint32_t seed = 0;
+    uint32_t cacheSeed = 0;              // Names the cache file
+    std::string cacheDir;
+    std::vector<GlyphBitmap> glyphs[MAX_CHAR_SIZE + 1]; // One per matrix char, read-only
+    std::vector<cv::Mat> frames[MAX_CHAR_SIZE + 1];     // CACHE_SIZE slots, one job each
+    std::atomic<uint32_t> readyMask[MAX_CHAR_SIZE + 1]; // Bit i set once frame i is done
+    std::atomic<int> remaining{0};
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> rendered{false};      // Every frame is in frames[]
+    std::atomic<bool> saved{false};         // ...and written to the cache file
+};
+
 StaticEffect::~StaticEffect() {
+    cancelBuild();
+    unmapCacheFile();
     if (ftFace_) FT_Done_Face(ftFace_);
     if (ftLibrary_) FT_Done_FreeType(ftLibrary_);
 }
 
-void StaticEffect::initialize(int width, int height) {
+bool StaticEffect::initialize(int width, int height) {
     width_ = width;
     height_ = height;
-    cachedFrames_.clear();
+    cancelBuild();
+    unmapCacheFile();
     currentFrame_ = 0;
     frameCounter_ = 0;
     currentCharSize_ = 0;
     animationComplete_ = false;
     startTime_ = 0;
+    seed_ = rng_.next();
 
     // Initialize matrix characters (Katakana)
     matrixChars_.clear();
@@ -56,7 +119,7 @@ void StaticEffect::initialize(int width, int height) {
     if (!ftLibrary_) {
         if (FT_Init_FreeType(&ftLibrary_) != 0) {
             std::cerr << "Failed to init FreeType for static effect\n";
-            return;
+            return false;
         }
     }
 
@@ -71,6 +134,20 @@ void StaticEffect::initialize(int width, int height) {
             }
         }
     }
+
+    if (mode_ == StaticMode::PROCEDURAL) {
+        noise_.release();
+        buildTiles();
+        return true;
+    }
+
+    // Every size at once, no decode: frames are views into the mapping.
+    // Otherwise render them in the background and show noise meanwhile.
+    noise_.create(height_, width_, CV_8UC1);
+    if (!mapCacheFile()) {
+        startBuild();
+    }
+    return true;
 }
 
 void StaticEffect::resetForIdle() {
@@ -78,8 +155,6 @@ void StaticEffect::resetForIdle() {
     startTime_ = getCurrentTimeMs();
     currentCharSize_ = MIN_CHAR_SIZE;
     animationComplete_ = false;
-    cachedFrames_.clear();
-    buildCachedFrames(currentCharSize_);
 }
 
 void StaticEffect::resetForEffect() {
@@ -87,198 +162,298 @@ void StaticEffect::resetForEffect() {
     startTime_ = getCurrentTimeMs();
     currentCharSize_ = MAX_CHAR_SIZE;
     animationComplete_ = true;  // No animation
-    cachedFrames_.clear();
-    buildCachedFrames(currentCharSize_);
 }
 
-void StaticEffect::renderChar(cv::Mat& img, wchar_t ch, int x, int y, uchar brightness, int charSize) {
-    if (!fontLoaded_ || !ftFace_) return;
-
-    FT_Set_Pixel_Sizes(ftFace_, 0, charSize);
-
-    FT_UInt glyphIndex = FT_Get_Char_Index(ftFace_, ch);
-    if (FT_Load_Glyph(ftFace_, glyphIndex, FT_LOAD_RENDER) != 0) return;
+// Cache builds are long and CPU-bound, so they get their own workers at the
+// background placement rather than inheriting the render thread's
+static ThreadPool& cachePool() {
+    static ThreadPool pool(0, [] { applyBackgroundPlacement("static cache"); });
+    return pool;
+}
 
-    FT_Bitmap& bitmap = ftFace_->glyph->bitmap;
-    int bx = ftFace_->glyph->bitmap_left;
-    int by = ftFace_->glyph->bitmap_top;
+void StaticEffect::startBuild() {
+    cancelBuild();
+    if (!fontLoaded_ || !ftFace_) {
+        return;
+    }
 
-    for (unsigned int row = 0; row < bitmap.rows; ++row) {
-        for (unsigned int col = 0; col < bitmap.width; ++col) {
-            int px = x + bx + col;
-            int py = y - by + row;
+    auto build = std::make_shared<CacheBuild>();
+    build->width = width_;
+    build->height = height_;
+    build->seed = rng_.next();
+    build->cacheSeed = cacheSeed_;
+    build->cacheDir = cacheDir_;
+
+    // FreeType isn't thread-safe: rasterize the glyphs here, once, and let
+    // the workers only composite them
+    for (int size = MIN_CHAR_SIZE; size <= MAX_CHAR_SIZE; ++size) {
+        build->glyphs[size] = rasterizeGlyphs(ftFace_, matrixChars_, size);
+        build->frames[size].resize(CACHE_SIZE);
+        build->readyMask[size].store(0);
+    }
+    build->remaining.store((MAX_CHAR_SIZE - MIN_CHAR_SIZE + 1) * CACHE_SIZE);
 
-            if (px >= 0 && px < img.cols && py >= 0 && py < img.rows) {
-                uchar alpha = bitmap.buffer[row * bitmap.pitch + col];
-                if (alpha > 0) {
-                    uchar val = static_cast<uchar>((alpha * brightness) / 255);
-                    cv::Vec3b& pixel = img.at<cv::Vec3b>(py, px);
-                    pixel[0] = pixel[1] = pixel[2] = std::max(pixel[0], val);
+    // One job per frame. Interleave sizes so each gets its first frames
+    // early, starting with the ones shown first (idle start, effect).
+    static const int order[] = {MIN_CHAR_SIZE, MAX_CHAR_SIZE, 2, 3, 4};
+    ThreadPool& pool = cachePool();
+    for (int f = 0; f < CACHE_SIZE; ++f) {
+        for (int size : order) {
+            pool.submit([build, size, f] {
+                if (build->cancelled.load()) return;
+                renderFrame(*build, size, f);
+                build->readyMask[size].fetch_or(1u << f, std::memory_order_release);
+                if (build->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && !build->cancelled.load()) {
+                    build->saved.store(saveCacheFile(*build), std::memory_order_release);
+                    build->rendered.store(true, std::memory_order_release);
                 }
-            }
+            });
         }
     }
+    build_ = build;
+}
+
+bool StaticEffect::isCacheComplete() const {
+    return cacheMap_ != nullptr || (build_ && build_->rendered.load(std::memory_order_acquire));
+}
+
+void StaticEffect::cancelBuild() {
+    if (build_) {
+        build_->cancelled.store(true);
+        build_.reset();
+    }
 }
 
-std::string StaticEffect::getCacheDir(int charSize) const {
+std::string StaticEffect::getCachePath(const std::string& dir, int width, int height, uint32_t seed) {
     std::ostringstream oss;
-    oss << CACHE_BASE << "/" << width_ << "x" << height_ << "_size" << charSize;
+    oss << dir << "/static_" << width << "x" << height;
+    if (seed) {
+        oss << "_seed" << seed;
+    }
+    oss << ".bin";
     return oss.str();
 }
 
-bool StaticEffect::loadCachedFramesFromDisk(int charSize) {
-    std::string cacheDir = getCacheDir(charSize);
+bool StaticEffect::mapCacheFile() {
+    std::string path = getCachePath(cacheDir_, width_, height_, cacheSeed_);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    const size_t frameBytes = static_cast<size_t>(width_) * height_;
+    const size_t sizeCount = MAX_CHAR_SIZE - MIN_CHAR_SIZE + 1;
+    const size_t expected = CACHE_DATA_OFFSET + frameBytes * CACHE_SIZE * sizeCount;
 
-    if (!std::filesystem::exists(cacheDir)) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != expected) {
+        close(fd);
         return false;
     }
 
-    cachedFrames_.clear();
-    cachedFrames_.reserve(CACHE_SIZE);
+    void* map = mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
 
-    for (int i = 0; i < CACHE_SIZE; ++i) {
-        std::ostringstream path;
-        path << cacheDir << "/frame_" << std::setfill('0') << std::setw(3) << i << ".png";
+    StaticCacheHeader header;
+    memcpy(&header, map, sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION ||
+        header.width != static_cast<uint32_t>(width_) || header.height != static_cast<uint32_t>(height_) ||
+        header.frameCount != CACHE_SIZE ||
+        header.minCharSize != MIN_CHAR_SIZE || header.maxCharSize != MAX_CHAR_SIZE) {
+        munmap(map, expected);
+        return false;
+    }
 
-        cv::Mat frame = cv::imread(path.str(), cv::IMREAD_COLOR);
-        if (frame.empty() || frame.cols != width_ || frame.rows != height_) {
-            cachedFrames_.clear();
-            return false;
+    unmapCacheFile();
+    cacheMap_ = map;
+    cacheMapSize_ = expected;
+
+    // Mapped read-only: the frames are never written, only converted from
+    uchar* data = static_cast<uchar*>(map) + CACHE_DATA_OFFSET;
+    for (int size = MIN_CHAR_SIZE; size <= MAX_CHAR_SIZE; ++size) {
+        cachedFrames_[size].clear();
+        for (int i = 0; i < CACHE_SIZE; ++i) {
+            cachedFrames_[size].emplace_back(height_, width_, CV_8UC1, data);
+            data += frameBytes;
         }
-        cachedFrames_.push_back(frame);
     }
-
     return true;
 }
 
-void StaticEffect::saveCachedFramesToDisk(int charSize) {
-    std::string cacheDir = getCacheDir(charSize);
+void StaticEffect::unmapCacheFile() {
+    if (!cacheMap_) {
+        return;
+    }
+    for (auto& frames : cachedFrames_) {
+        frames.clear();
+    }
+    munmap(cacheMap_, cacheMapSize_);
+    cacheMap_ = nullptr;
+    cacheMapSize_ = 0;
+}
 
+bool StaticEffect::saveCacheFile(const CacheBuild& build) {
     try {
-        std::filesystem::create_directories(cacheDir);
+        std::filesystem::create_directories(build.cacheDir);
     } catch (const std::exception& e) {
         std::cerr << "Failed to create cache directory: " << e.what() << std::endl;
-        return;
+        return false;
     }
 
-    for (size_t i = 0; i < cachedFrames_.size(); ++i) {
-        std::ostringstream path;
-        path << cacheDir << "/frame_" << std::setfill('0') << std::setw(3) << i << ".png";
-        cv::imwrite(path.str(), cachedFrames_[i]);
+    // Write under a temporary name and rename, so a concurrent reader never
+    // maps a half-written file
+    std::string path = getCachePath(build.cacheDir, build.width, build.height, build.cacheSeed);
+    static std::atomic<int> saveCount{0};
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(saveCount++);
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to write static cache " << tmpPath << ": " << strerror(errno) << std::endl;
+        return false;
     }
-}
 
-void StaticEffect::buildCachedFrames(int charSize) {
-    // Try to load from disk cache first
-    if (loadCachedFramesFromDisk(charSize)) {
-        return;  // Successfully loaded from cache
+    std::vector<char> header(CACHE_DATA_OFFSET, 0);
+    StaticCacheHeader h{};
+    memcpy(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    h.version = CACHE_VERSION;
+    h.width = build.width;
+    h.height = build.height;
+    h.frameCount = CACHE_SIZE;
+    h.minCharSize = MIN_CHAR_SIZE;
+    h.maxCharSize = MAX_CHAR_SIZE;
+    memcpy(header.data(), &h, sizeof(h));
+
+    bool ok = write(fd, header.data(), header.size()) == static_cast<ssize_t>(header.size());
+    const size_t frameBytes = static_cast<size_t>(build.width) * build.height;
+    for (int size = MIN_CHAR_SIZE; size <= MAX_CHAR_SIZE && ok; ++size) {
+        for (const cv::Mat& frame : build.frames[size]) {
+            if (write(fd, frame.data, frameBytes) != static_cast<ssize_t>(frameBytes)) {
+                ok = false;
+                break;
+            }
+        }
     }
+    close(fd);
 
-    cachedFrames_.clear();
-    cachedFrames_.reserve(CACHE_SIZE);
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to write static cache " << path << ": " << strerror(errno) << std::endl;
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
 
-    std::uniform_int_distribution<size_t> charDist(0, matrixChars_.size() - 1);
-    std::uniform_int_distribution<int> brightDist(100, 255);
-    std::uniform_int_distribution<int> bandCountDist(5, 25);
-    std::uniform_int_distribution<int> bandHeightDist(2, 40);
+void StaticEffect::renderFrame(CacheBuild& build, int charSize, int index) {
+    // Seeded per frame so jobs don't share RNG state
+    FastRng frameRng(build.seed ^ (charSize * 7919u + index * 104729u));
+    const std::vector<GlyphBitmap>& glyphs = build.glyphs[charSize];
+    const uint32_t glyphCount = static_cast<uint32_t>(glyphs.size());
+    const int width = build.width;
+    const int height = build.height;
 
     int charWidth = std::max(charSize, 2);
     int charHeight = charSize + 1;
-    int cols = width_ / charWidth;
-    int rows = height_ / charHeight;
-
-    for (int f = 0; f < CACHE_SIZE; ++f) {
-        cv::Mat frame = cv::Mat::zeros(height_, width_, CV_8UC3);
-
-        // Fill with random matrix characters at varying brightness
-        for (int row = 0; row < rows; ++row) {
-            for (int col = 0; col < cols; ++col) {
-                wchar_t ch = matrixChars_[charDist(rng)];
-                uchar brightness = static_cast<uchar>(brightDist(rng));
-                int x = col * charWidth;
-                int y = (row + 1) * charHeight;
-                renderChar(frame, ch, x, y, brightness, charSize);
+    int cols = width / charWidth;
+    int rows = height / charHeight;
+
+    cv::Mat frame = cv::Mat::zeros(height, width, CV_8UC1);
+    std::vector<uint32_t> cellRandom(cols);
+
+    // Fill with random matrix characters at varying brightness; one value per
+    // cell, low half picks the glyph and high half the brightness
+    for (int row = 0; row < rows; ++row) {
+        frameRng.fill(cellRandom.data(), cellRandom.size());
+        for (int col = 0; col < cols; ++col) {
+            uint32_t r = cellRandom[col];
+            const GlyphBitmap& glyph = glyphs[((r & 0xffff) * glyphCount) >> 16];
+            int brightness = 100 + static_cast<int>(((r >> 16) * 156) >> 16);
+            if (glyph.alpha.empty()) continue;
+
+            int x0 = col * charWidth + glyph.left;
+            int y0 = (row + 1) * charHeight - glyph.top;
+            for (int gy = std::max(0, -y0); gy < glyph.alpha.rows && y0 + gy < height; ++gy) {
+                const uchar* src = glyph.alpha.ptr<uchar>(gy);
+                uchar* dst = frame.ptr<uchar>(y0 + gy);
+                for (int gx = std::max(0, -x0); gx < glyph.alpha.cols && x0 + gx < width; ++gx) {
+                    uchar val = static_cast<uchar>((src[gx] * brightness) / 255);
+                    dst[x0 + gx] = std::max(dst[x0 + gx], val);
+                }
             }
         }
+    }
 
-        // Add horizontal bands for TV effect
-        int numBands = bandCountDist(rng);
-        std::uniform_int_distribution<int> bandStartDist(0, height_ - 1);
-
-        for (int b = 0; b < numBands; ++b) {
-            int startY = bandStartDist(rng);
-            int bandHeight = std::min(bandHeightDist(rng), height_ - startY);
-            bool isBright = (rng() % 2) == 0;
-
-            for (int y = startY; y < startY + bandHeight && y < height_; ++y) {
-                cv::Vec3b* rowPtr = frame.ptr<cv::Vec3b>(y);
-                for (int x = 0; x < width_; ++x) {
-                    if (isBright) {
-                        for (int c = 0; c < 3; ++c) {
-                            rowPtr[x][c] = std::min(255, rowPtr[x][c] + 60);
-                        }
-                    } else {
-                        for (int c = 0; c < 3; ++c) {
-                            rowPtr[x][c] = static_cast<uchar>(rowPtr[x][c] * 0.5);
-                        }
-                    }
+    // Add horizontal bands for TV effect
+    int numBands = frameRng.range(5, 25);
+
+    for (int b = 0; b < numBands; ++b) {
+        int startY = static_cast<int>(frameRng.below(height));
+        int bandHeight = std::min(frameRng.range(2, 40), height - startY);
+        bool isBright = frameRng.below(2) == 0;
+
+        for (int y = startY; y < startY + bandHeight && y < height; ++y) {
+            uchar* rowPtr = frame.ptr<uchar>(y);
+            for (int x = 0; x < width; ++x) {
+                if (isBright) {
+                    rowPtr[x] = static_cast<uchar>(std::min(255, rowPtr[x] + 60));
+                } else {
+                    rowPtr[x] = static_cast<uchar>(rowPtr[x] * 0.5);
                 }
             }
         }
+    }
 
-        // Subtle scanline effect
-        for (int y = 0; y < height_; y += 2) {
-            cv::Vec3b* rowPtr = frame.ptr<cv::Vec3b>(y);
-            for (int x = 0; x < width_; ++x) {
-                for (int c = 0; c < 3; ++c) {
-                    rowPtr[x][c] = static_cast<uchar>(rowPtr[x][c] * 0.9);
-                }
-            }
+    // Subtle scanline effect
+    for (int y = 0; y < height; y += 2) {
+        uchar* rowPtr = frame.ptr<uchar>(y);
+        for (int x = 0; x < width; ++x) {
+            rowPtr[x] = static_cast<uchar>(rowPtr[x] * 0.9);
         }
+    }
 
-        cachedFrames_.push_back(frame);
+    build.frames[charSize][index] = frame;
+}
+
+const cv::Mat* StaticEffect::readyFrame(int charSize, size_t index) const {
+    const std::vector<cv::Mat>& mapped = cachedFrames_[charSize];
+    if (!mapped.empty()) {
+        return &mapped[index % mapped.size()];
+    }
+    if (!build_) {
+        return nullptr;
     }
 
-    // Save to disk for future runs
-    saveCachedFramesToDisk(charSize);
+    // Size still building: serve whichever frames are finished
+    uint32_t mask = build_->readyMask[charSize].load(std::memory_order_acquire);
+    for (int i = 0; i < CACHE_SIZE && mask; ++i) {
+        size_t f = (index + i) % CACHE_SIZE;
+        if (mask & (1u << f)) {
+            return &build_->frames[charSize][f];
+        }
+    }
+    return nullptr;
 }
 
-cv::Mat StaticEffect::generate() {
+void StaticEffect::update(uint64_t) {
     // Initialize on first call if not reset
     if (startTime_ == 0) {
         resetForIdle();
     }
 
-    // If no cached frames (font failed), fall back to noise
-    if (cachedFrames_.empty()) {
-        cv::Mat noise(height_, width_, CV_8UC1);
-        cv::randu(noise, cv::Scalar(0), cv::Scalar(255));
-        cv::Mat buffer;
-        cv::cvtColor(noise, buffer, cv::COLOR_GRAY2BGR);
-        return buffer;
-    }
-
     // Calculate current character size based on elapsed time
     if (!animationComplete_) {
         uint64_t elapsed = getCurrentTimeMs() - startTime_;
 
         if (elapsed >= GROW_DURATION_MS) {
             // Animation complete, stay at max size
-            if (currentCharSize_ != MAX_CHAR_SIZE) {
-                currentCharSize_ = MAX_CHAR_SIZE;
-                buildCachedFrames(currentCharSize_);
-            }
+            currentCharSize_ = MAX_CHAR_SIZE;
             animationComplete_ = true;
         } else {
             // Interpolate size from MIN to MAX over duration
             float progress = static_cast<float>(elapsed) / GROW_DURATION_MS;
-            int targetSize = MIN_CHAR_SIZE + static_cast<int>(progress * (MAX_CHAR_SIZE - MIN_CHAR_SIZE));
-
-            // Rebuild cache if size changed
-            if (targetSize != currentCharSize_) {
-                currentCharSize_ = targetSize;
-                buildCachedFrames(currentCharSize_);
-            }
+            currentCharSize_ = MIN_CHAR_SIZE + static_cast<int>(progress * (MAX_CHAR_SIZE - MIN_CHAR_SIZE));
         }
     }
 
@@ -286,8 +461,157 @@ cv::Mat StaticEffect::generate() {
     frameCounter_++;
     if (frameCounter_ >= framesPerSwitch_) {
         frameCounter_ = 0;
-        currentFrame_ = (currentFrame_ + 1) % cachedFrames_.size();
+        currentFrame_++;
     }
 
-    return cachedFrames_[currentFrame_].clone();
+    // Build finished and written out: serve from the mapping instead of
+    // keeping a private copy of every frame. If the save failed the frames
+    // in memory stay in use.
+    if (build_ && build_->saved.exchange(false, std::memory_order_acq_rel) && mapCacheFile()) {
+        build_.reset();
+    }
+}
+
+const cv::Mat& StaticEffect::currentFrame() {
+    // No frames yet (still rendering, or no font): fall back to noise
+    const cv::Mat* frame = readyFrame(currentCharSize_, currentFrame_);
+    if (!frame) {
+        cv::randu(noise_, cv::Scalar(0), cv::Scalar(255));
+        return noise_;
+    }
+    return *frame;
+}
+
+void StaticEffect::buildTiles() {
+    for (int size = MIN_CHAR_SIZE; size <= MAX_CHAR_SIZE; ++size) {
+        const int charWidth = std::max(size, 2);
+        const int charHeight = size + 1;
+        const size_t tileBytes = static_cast<size_t>(TILE_STRIDE) * charHeight;
+        std::vector<uint8_t>& tiles = tiles_[size];
+
+        // No font: solid cells still read as blocky static
+        if (!fontLoaded_ || !ftFace_) {
+            tiles.assign(matrixChars_.size() * tileBytes, 255);
+            continue;
+        }
+
+        // Same placement as the cached frames, clipped to the cell
+        tiles.assign(matrixChars_.size() * tileBytes, 0);
+        std::vector<GlyphBitmap> glyphs = rasterizeGlyphs(ftFace_, matrixChars_, size);
+        for (size_t i = 0; i < glyphs.size(); ++i) {
+            const GlyphBitmap& glyph = glyphs[i];
+            uint8_t* tile = tiles.data() + i * tileBytes;
+            for (int gy = 0; gy < glyph.alpha.rows; ++gy) {
+                int y = charHeight - glyph.top + gy;
+                if (y < 0 || y >= charHeight) continue;
+                const uchar* src = glyph.alpha.ptr<uchar>(gy);
+                for (int gx = 0; gx < glyph.alpha.cols; ++gx) {
+                    int x = glyph.left + gx;
+                    if (x < 0 || x >= charWidth) continue;
+                    tile[y * TILE_STRIDE + x] = std::max(tile[y * TILE_STRIDE + x], src[gx]);
+                }
+            }
+        }
+    }
+
+    glyphRow_.assign(width_, 0);
+    brightRow_.assign(width_, 0);
+    tileRow_.assign(width_ + TILE_STRIDE, 0);
+    grayRow_.assign(width_, 0);
+    bandRow_.assign(height_, 0);
+}
+
+template <PixelFormat F>
+void StaticEffect::renderProcedural(cv::Mat& dst) {
+    enum : uint8_t { BAND_NONE, BAND_BRIGHT, BAND_DARK };
+
+    const int size = currentCharSize_;
+    if (size < MIN_CHAR_SIZE || size > MAX_CHAR_SIZE || tiles_[size].empty() ||
+        static_cast<int>(bandRow_.size()) != height_) {
+        return;
+    }
+
+    const int charWidth = std::max(size, 2);
+    const int charHeight = size + 1;
+    const int cols = width_ / charWidth;
+    const int rows = height_ / charHeight;
+    const uint32_t glyphCount = static_cast<uint32_t>(matrixChars_.size());
+    const uint32_t tileBytes = TILE_STRIDE * charHeight;
+    const uint8_t* tiles = tiles_[size].data();
+    const uint32_t frameSeed = hash32(seed_ ^ hash32(static_cast<uint32_t>(currentFrame_) * 8 + size));
+
+    // Bands, same ranges as the cached frames; the last one wins on overlap
+    std::fill(bandRow_.begin(), bandRow_.end(), BAND_NONE);
+    int numBands = 5 + hash32(frameSeed) % 21;
+    for (int b = 0; b < numBands; ++b) {
+        uint32_t h = hash32(frameSeed + b + 1);
+        int startY = h % height_;
+        int endY = std::min(height_, startY + 2 + static_cast<int>((h >> 12) % 39));
+        std::fill(bandRow_.begin() + startY, bandRow_.begin() + endY, (h >> 31) ? BAND_BRIGHT : BAND_DARK);
+    }
+
+    for (int y = 0; y < height_; ++y) {
+        const int cellRow = y / charHeight;
+        const int ty = y - cellRow * charHeight;
+
+        if (cellRow < rows) {
+            // New row of cells: pick glyph and brightness per cell
+            if (ty == 0) {
+                uint32_t cellBase = frameSeed + static_cast<uint32_t>(cellRow * cols);
+                for (int c = 0; c < cols; ++c) {
+                    uint32_t h = hash32(cellBase + c);
+                    glyphRow_[c] = (h % glyphCount) * tileBytes;
+                    std::fill_n(brightRow_.data() + c * charWidth, charWidth, static_cast<uint8_t>(100 + (h >> 16) % 156));
+                }
+                std::fill(brightRow_.begin() + cols * charWidth, brightRow_.end(), 0);
+            }
+
+            // Fixed-size copies: each one spills past the cell into the next,
+            // which then overwrites it (tileRow_ has TILE_STRIDE bytes of slack)
+            const uint8_t* tileLine = tiles + ty * TILE_STRIDE;
+            uint8_t* out = tileRow_.data();
+            for (int c = 0; c < cols; ++c, out += charWidth) {
+                std::memcpy(out, tileLine + glyphRow_[c], TILE_STRIDE);
+            }
+        } else if (y == rows * charHeight) {
+            // Leftover rows below the last full cell stay empty
+            std::fill(brightRow_.begin(), brightRow_.end(), 0);
+        }
+
+        // Band and scanline become per-row constants for the SIMD shader;
+        // for YUYV the scale also maps to limited-range luma
+        const uint8_t band = bandRow_[y];
+        const bool scanline = (y % 2) == 0;
+        const int bandShift = band == BAND_DARK ? 1 : 0;
+        const int bandAdd = band == BAND_BRIGHT ? 60 : 0;
+        if constexpr (F == PixelFormat::YUYV) {
+            shadeStaticRowYUYV(dst.ptr<uint8_t>(y), tileRow_.data(), brightRow_.data(), width_,
+                               bandShift, bandAdd, scanline ? 198 : 220);
+        } else if constexpr (F == PixelFormat::GRAY8) {
+            shadeStaticRowGray(dst.ptr<uint8_t>(y), tileRow_.data(), brightRow_.data(), width_,
+                               bandShift, bandAdd, scanline ? 230 : 256);
+        } else {
+            shadeStaticRowGray(grayRow_.data(), tileRow_.data(), brightRow_.data(), width_,
+                               bandShift, bandAdd, scanline ? 230 : 256);
+            composeGrayRow<F>(dst.ptr<uint8_t>(y), grayRow_.data(), width_);
+        }
+    }
+}
+
+void StaticEffect::renderInto(cv::Mat& dst, PixelFormat format, BlendMode, const cv::Mat&, float) {
+    dst.create(height_, width_, pixelFormatType(format));
+    if (mode_ == StaticMode::PROCEDURAL) {
+        dispatchRender(format, BlendMode::REPLACE, [&](auto f, auto) {
+            renderProcedural<decltype(f)::value>(dst);
+        });
+        return;
+    }
+
+    // Cached frames are grayscale, so YUYV luma comes from a table and chroma is constant
+    const cv::Mat& frame = currentFrame();
+    dispatchRender(format, BlendMode::REPLACE, [&](auto f, auto) {
+        for (int y = 0; y < height_; ++y) {
+            composeGrayRow<decltype(f)::value>(dst.ptr<uint8_t>(y), frame.ptr<uint8_t>(y), width_);
+        }
+    });
 }
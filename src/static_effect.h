@@ -3,45 +3,103 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstdint>
+#include "config.h"
+#include "effect.h"
+#include "fast_rng.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
-class StaticEffect {
+class StaticEffect : public Effect {
 public:
     StaticEffect() = default;
-    ~StaticEffect();
+    ~StaticEffect() override;
 
-    void initialize(int width, int height);
+    const char* name() const override { return "static"; }
+    void setMode(StaticMode mode) { mode_ = mode; }  // Applies from the next initialize()
+    // Reproducible frames from the next initialize(); cached frames for a seed get their own file
+    void setSeed(uint32_t seed) {
+        rng_.setSeed(seed);
+        cacheSeed_ = seed;
+    }
+    void setCacheDir(const std::string& dir) { cacheDir_ = dir; }  // Applies from the next initialize()
+    bool initialize(int width, int height) override;
+    void update(uint64_t currentTimeMs) override;
+    void reset() override { resetForEffect(); }
     void resetForIdle();   // Growing static while waiting for camera
     void resetForEffect(); // Instant full-size static for effect sequence
-    cv::Mat generate();
+
+    // Static is opaque: mode and background are ignored
+    void renderInto(cv::Mat& dst, PixelFormat format, BlendMode mode = BlendMode::REPLACE,
+                    const cv::Mat& background = cv::Mat(), float opacity = 0.9f) override;
+
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+    StaticMode getMode() const { return mode_; }
+    bool isFontLoaded() const { return fontLoaded_; }
+    // Cached mode: every frame is mapped from disk, or rendered (the file is
+    // written when possible; frames stay in memory if that fails)
+    bool isCacheComplete() const;
+    static int getCacheFrameCount() { return CACHE_SIZE * (MAX_CHAR_SIZE - MIN_CHAR_SIZE + 1); }
 
 private:
-    void buildCachedFrames(int charSize);
-    void renderChar(cv::Mat& img, wchar_t ch, int x, int y, uchar brightness, int charSize);
-    bool loadCachedFramesFromDisk(int charSize);
-    void saveCachedFramesToDisk(int charSize);
-    std::string getCacheDir(int charSize) const;
+    static constexpr int CACHE_SIZE = 30;       // ~1 second at 30fps
+    static constexpr int MIN_CHAR_SIZE = 1;     // Start tiny
+    static constexpr int MAX_CHAR_SIZE = 5;     // Final size
+    static constexpr uint64_t GROW_DURATION_MS = 10000;  // 10 seconds
+    static constexpr int TILE_STRIDE = 8;       // Bytes per tile row (>= widest cell)
+    static constexpr const char* DEFAULT_CACHE_DIR = "/tmp/matrix-filter-static";
+
+    // Frames being rendered by the worker pool (defined in the .cpp)
+    struct CacheBuild;
+
+    const cv::Mat& currentFrame();
+    const cv::Mat* readyFrame(int charSize, size_t index) const;
+    void startBuild();
+    void cancelBuild();
+    bool mapCacheFile();
+    void unmapCacheFile();
+    void buildTiles();
+    template <PixelFormat F> void renderProcedural(cv::Mat& dst);
+
+    static void renderFrame(CacheBuild& build, int charSize, int index);
+    static bool saveCacheFile(const CacheBuild& build);
+    static std::string getCachePath(const std::string& dir, int width, int height, uint32_t seed);
 
     int width_ = 0;
     int height_ = 0;
+    StaticMode mode_ = StaticMode::CACHED;
+    std::string cacheDir_ = DEFAULT_CACHE_DIR;
+    uint32_t cacheSeed_ = 0;                // From setSeed(), 0 = unseeded cache shared by every run
 
-    // Cached frames (loaded from disk or generated)
-    std::vector<cv::Mat> cachedFrames_;
+    // Grayscale frames per char size as views into the mapped cache file;
+    // empty while the cache is being built
+    std::vector<cv::Mat> cachedFrames_[MAX_CHAR_SIZE + 1];
+    void* cacheMap_ = nullptr;
+    size_t cacheMapSize_ = 0;
+    std::shared_ptr<CacheBuild> build_;
     size_t currentFrame_ = 0;
     int frameCounter_ = 0;
     int framesPerSwitch_ = 8;  // Show each cached frame for N generate() calls (slower)
+    cv::Mat noise_;            // Grayscale fallback until frames are ready
+
+    // Procedural mode: one cell-sized tile per matrix char per size (a few KB),
+    // shaded per frame from a hash instead of stored frames
+    std::vector<uint8_t> tiles_[MAX_CHAR_SIZE + 1];
+    std::vector<uint32_t> glyphRow_;   // Tile offset per cell of the current cell row
+    std::vector<uint8_t> brightRow_;   // Cell brightness, expanded per pixel
+    std::vector<uint8_t> tileRow_;     // Tile pixels of the current output row
+    std::vector<uint8_t> bandRow_;     // Band kind per output row
+    uint32_t seed_ = 0;                // Procedural stream, drawn from rng_ per initialize()
+    FastRng rng_;
+    std::vector<uint8_t> grayRow_;     // Shaded row before expanding to BGR
 
     // Size animation
     uint64_t startTime_ = 0;
     int currentCharSize_ = 0;
     bool animationComplete_ = false;
 
-    static constexpr int CACHE_SIZE = 30;       // ~1 second at 30fps
-    static constexpr int MIN_CHAR_SIZE = 1;     // Start tiny
-    static constexpr int MAX_CHAR_SIZE = 5;     // Final size
-    static constexpr uint64_t GROW_DURATION_MS = 10000;  // 10 seconds
-
     // FreeType
     FT_Library ftLibrary_ = nullptr;
     FT_Face ftFace_ = nullptr;
@@ -0,0 +1,140 @@
+#include "stats_server.h"
+#include "stage_stats.h"
+#include "thread_placement.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+
+// How long a client gets to send its request before we answer anyway
+static constexpr int REQUEST_TIMEOUT_MS = 100;
+
+StatsServer::~StatsServer() {
+    stop();
+}
+
+bool StatsServer::start(const std::string& path) {
+    stop();
+
+    struct sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Stats socket path too long: " << path << std::endl;
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "Failed to create stats socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Replace a stale socket from an earlier run, but never anything else
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            std::cerr << "Stats socket path exists and is not a socket: " << path << std::endl;
+            ::close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(listenFd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listenFd_, 4) < 0) {
+        std::cerr << "Failed to listen on " << path << ": " << strerror(errno) << std::endl;
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    path_ = path;
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    stop_.store(false);
+    thread_ = std::thread(&StatsServer::run, this);
+    return true;
+}
+
+void StatsServer::stop() {
+    if (thread_.joinable()) {
+        stop_.store(true);
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t r = write(wakeFd_, &one, sizeof(one));
+        thread_.join();
+    }
+
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        unlink(path_.c_str());
+    }
+    if (wakeFd_ >= 0) {
+        ::close(wakeFd_);
+    }
+    listenFd_ = wakeFd_ = -1;
+}
+
+void StatsServer::run() {
+    applyBackgroundPlacement("stats server");
+    while (!stop_.load()) {
+        struct pollfd fds[2] = {
+            {wakeFd_, POLLIN, 0},
+            {listenFd_, POLLIN, 0}
+        };
+        int r = poll(fds, 2, -1);
+        if (r < 0 && errno != EINTR) {
+            std::cerr << "Stats server poll failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        if (stop_.load()) {
+            break;
+        }
+
+        if (r > 0 && (fds[1].revents & POLLIN)) {
+            int clientFd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (clientFd >= 0) {
+                serve(clientFd);
+                ::close(clientFd);
+            }
+        }
+    }
+}
+
+void StatsServer::serve(int clientFd) {
+    // Read whatever request arrives first; closing with unread data would
+    // reset the connection under an HTTP client
+    char request[1024];
+    ssize_t len = 0;
+    struct pollfd pfd = {clientFd, POLLIN, 0};
+    if (poll(&pfd, 1, REQUEST_TIMEOUT_MS) > 0) {
+        len = recv(clientFd, request, sizeof(request), MSG_DONTWAIT);
+    }
+    bool http = len >= 4 && std::memcmp(request, "GET ", 4) == 0;
+
+    std::string body = StageStats::instance().formatPrometheus();
+    std::string response;
+    if (http) {
+        response = "HTTP/1.0 200 OK\r\n"
+                   "Content-Type: text/plain; version=0.0.4\r\n"
+                   "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                   "Connection: close\r\n\r\n";
+    }
+    response += body;
+
+    const char* p = response.data();
+    size_t remaining = response.size();
+    while (remaining > 0) {
+        ssize_t written = send(clientFd, p, remaining, MSG_NOSIGNAL);
+        if (written <= 0) {
+            if (written < 0 && errno == EINTR) continue;
+            break;
+        }
+        p += written;
+        remaining -= written;
+    }
+}
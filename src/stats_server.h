@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <thread>
+
+// Serves StageStats as Prometheus text on a Unix socket. Each connection gets
+// one snapshot and is closed; HTTP GETs (curl --unix-socket, a scraping
+// proxy) get a minimal HTTP response, anything else the plain text.
+class StatsServer {
+public:
+    StatsServer() = default;
+    ~StatsServer();
+
+    StatsServer(const StatsServer&) = delete;
+    StatsServer& operator=(const StatsServer&) = delete;
+
+    // Replaces a stale socket file at path
+    bool start(const std::string& path);
+    void stop();
+
+private:
+    void run();
+    void serve(int clientFd);
+
+    std::string path_;
+    int listenFd_ = -1;
+    int wakeFd_ = -1;                   // eventfd to interrupt poll() on stop()
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+};
@@ -0,0 +1,213 @@
+#include "thread_placement.h"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+bool parseCpuList(const std::string& list, std::vector<int>& cpus) {
+    cpus.clear();
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string entry = list.substr(pos, end - pos);
+        pos = end + 1;
+
+        int first, last;
+        char extra;
+        int matched = std::sscanf(entry.c_str(), "%d-%d%c", &first, &last, &extra);
+        if (matched == 1) {
+            // A single CPU, unless something other than a range follows
+            if (std::sscanf(entry.c_str(), "%d%c", &first, &extra) != 1) return false;
+            last = first;
+        } else if (matched != 2) {
+            return false;
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return !cpus.empty();
+}
+
+std::vector<int> getAllowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> restrictCpus(const std::vector<int>& cpus, const std::vector<int>& allowed) {
+    std::vector<int> result;
+    for (int cpu : cpus) {
+        if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+            result.push_back(cpu);
+        }
+    }
+    return result;
+}
+
+// NUMA node of a CPU from its nodeN link in sysfs, -1 if not reported
+static int cpuNode(int cpu) {
+    std::error_code ec;
+    std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        int node;
+        char extra;
+        if (std::sscanf(name.c_str(), "node%d%c", &node, &extra) == 1) {
+            return node;
+        }
+    }
+    return -1;
+}
+
+// Collapse consecutive CPUs into ranges: "0-3,6"
+static std::string formatList(const std::vector<int>& values) {
+    std::string out;
+    for (size_t i = 0; i < values.size();) {
+        size_t j = i;
+        while (j + 1 < values.size() && values[j + 1] == values[j] + 1) ++j;
+        if (!out.empty()) out += ",";
+        out += std::to_string(values[i]);
+        if (j > i) out += "-" + std::to_string(values[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+std::string describeCpus(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return "any";
+    }
+    std::set<int> nodes;
+    for (int cpu : cpus) {
+        int node = cpuNode(cpu);
+        if (node >= 0) nodes.insert(node);
+    }
+    std::string out = formatList(cpus);
+    if (!nodes.empty()) {
+        out += nodes.size() == 1 ? " (node " : " (nodes ";
+        out += formatList(std::vector<int>(nodes.begin(), nodes.end())) + ")";
+    }
+    return out;
+}
+
+std::string describePolicy(RealtimePolicy policy, int priority) {
+    switch (policy) {
+        case RealtimePolicy::FIFO: return "SCHED_FIFO priority " + std::to_string(priority);
+        case RealtimePolicy::RR:   return "SCHED_RR priority " + std::to_string(priority);
+        case RealtimePolicy::NONE: break;
+    }
+    return "normal";
+}
+
+std::string describeThreadPolicy() {
+    int policy = SCHED_OTHER;
+    struct sched_param param{};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    switch (policy) {
+        case SCHED_FIFO: return describePolicy(RealtimePolicy::FIFO, param.sched_priority);
+        case SCHED_RR:   return describePolicy(RealtimePolicy::RR, param.sched_priority);
+        default:         return describePolicy(RealtimePolicy::NONE, 0);
+    }
+}
+
+bool applyPlacement(const char* threadName, const ThreadPlacement& placement) {
+    bool ok = true;
+
+    if (!placement.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : placement.cpus) {
+            CPU_SET(cpu, &set);
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            std::cerr << "Warning: can't pin " << threadName << " thread to CPUs "
+                      << formatList(placement.cpus) << ": " << strerror(err) << std::endl;
+            ok = false;
+        }
+    }
+
+    if (placement.policy != RealtimePolicy::NONE) {
+        struct sched_param param{};
+        param.sched_priority = placement.priority;
+        int policy = placement.policy == RealtimePolicy::FIFO ? SCHED_FIFO : SCHED_RR;
+        int err = pthread_setschedparam(pthread_self(), policy, &param);
+        if (err != 0) {
+            std::cerr << "Warning: can't give " << threadName << " thread "
+                      << describePolicy(placement.policy, placement.priority) << ": " << strerror(err)
+                      << (err == EPERM ? " (needs CAP_SYS_NICE or an rtprio limit)" : "") << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static ThreadPlacement backgroundPlacement;
+static bool backgroundPlacementSet = false;
+
+void setBackgroundPlacement(const ThreadPlacement& placement) {
+    backgroundPlacement = placement;
+    backgroundPlacementSet = true;
+}
+
+void applyBackgroundPlacement(const char* threadName) {
+    if (!backgroundPlacementSet) {
+        return;
+    }
+    applyPlacement(threadName, backgroundPlacement);
+
+    // Drop a real-time policy inherited from the starting thread
+    struct sched_param param{};
+    int policy = SCHED_OTHER;
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    if (policy != SCHED_OTHER && backgroundPlacement.policy == RealtimePolicy::NONE) {
+        param.sched_priority = 0;
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    }
+}
+
+bool lockMemory() {
+    // With MCL_FUTURE every mapping past the limit fails, which would turn
+    // the next frame allocation into a crash; only lock when it can't happen
+    struct rlimit limit{};
+    getrlimit(RLIMIT_MEMLOCK, &limit);
+    if (limit.rlim_cur != RLIM_INFINITY && geteuid() != 0) {
+        std::cerr << "Warning: not locking memory, the locked memory limit is "
+                  << (limit.rlim_cur >> 10) << " KiB (use ulimit -l unlimited)" << std::endl;
+        return false;
+    }
+
+    int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+    // Lock pages as they are touched, so the mmapped static cache isn't read in up front
+    if (mlockall(flags | MCL_ONFAULT) == 0) {
+        return true;
+    }
+#endif
+    if (mlockall(flags) != 0) {
+        std::cerr << "Warning: mlockall failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
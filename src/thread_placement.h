@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "config.h"
+
+// CPU pinning and real-time scheduling for the pipeline threads. Each thread
+// applies its own placement when it starts, and with the kernel's default
+// local-node policy memory lands on the node of the thread that first
+// touches it: capture ring slots on the capture thread's, effect buffers and
+// output ring slots on the render thread's (the output thread only reads
+// them). Camera and loopback mmap buffers belong to the driver. Per-frame
+// worker pools inherit the render thread's CPUs and policy; monitor and
+// server threads and the static cache build switch to the background
+// placement instead.
+struct ThreadPlacement {
+    std::vector<int> cpus;                      // Empty = wherever the scheduler likes
+    RealtimePolicy policy = RealtimePolicy::NONE;
+    int priority = 0;                           // 1-99 for real-time policies
+};
+
+// "3", "0-3" or "0,2,4-5"; false on anything else
+bool parseCpuList(const std::string& list, std::vector<int>& cpus);
+
+// CPUs the calling thread may run on now
+std::vector<int> getAllowedCpus();
+
+// cpus limited to allowed, in order
+std::vector<int> restrictCpus(const std::vector<int>& cpus, const std::vector<int>& allowed);
+
+// "4-7 (node 1)", or "any" for an empty set
+std::string describeCpus(const std::vector<int>& cpus);
+
+// "SCHED_FIFO priority 10", or "normal"
+std::string describePolicy(RealtimePolicy policy, int priority);
+std::string describeThreadPolicy();     // The calling thread's current policy
+
+// Apply to the calling thread; warns and returns false on any part that failed
+bool applyPlacement(const char* threadName, const ThreadPlacement& placement);
+
+// Placement for helper threads off the frame path (device and consumer
+// monitors, stats server, static cache build): normally every CPU and
+// SCHED_OTHER. Set before starting them; applyBackgroundPlacement() does
+// nothing until then.
+void setBackgroundPlacement(const ThreadPlacement& placement);
+void applyBackgroundPlacement(const char* threadName);
+
+// Lock current and future pages in RAM (pages fault in before locking where
+// the kernel allows). Skipped with a warning when RLIMIT_MEMLOCK would make
+// later allocations fail.
+bool lockMemory();
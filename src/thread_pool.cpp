@@ -0,0 +1,110 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threads, std::function<void()> onStart) {
+    if (threads <= 0) {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    workers_.reserve(threads);
+    for (int i = 0; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, onStart);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        jobs_.clear();
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::runBulkItems() {
+    int i;
+    while ((i = bulkNext_.fetch_add(1, std::memory_order_relaxed)) < bulkCount_) {
+        bulkFn_(bulkCtx_, i);
+    }
+}
+
+void ThreadPool::runBulk(int count, void (*fn)(void*, int), void* ctx) {
+    if (count <= 0) {
+        return;
+    }
+    if (count == 1 || workers_.empty()) {
+        for (int i = 0; i < count; ++i) fn(ctx, i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> bulkLock(bulkMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bulkFn_ = fn;
+        bulkCtx_ = ctx;
+        bulkCount_ = count;
+        bulkNext_.store(0, std::memory_order_relaxed);
+        bulkGeneration_++;
+    }
+    cv_.notify_all();
+
+    runBulkItems();
+
+    // Items are all claimed; wait for workers still running theirs
+    std::unique_lock<std::mutex> lock(mutex_);
+    bulkDoneCv_.wait(lock, [this] { return bulkActive_ == 0; });
+    bulkCount_ = 0;
+}
+
+void ThreadPool::workerLoop(const std::function<void()>& onStart) {
+    if (onStart) {
+        onStart();
+    }
+    uint64_t seenGeneration = 0;
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] {
+                return stopping_ || !jobs_.empty() || bulkGeneration_ != seenGeneration;
+            });
+            if (stopping_) {
+                return;
+            }
+
+            // Help with a parallelFor first, it has a caller waiting
+            if (bulkGeneration_ != seenGeneration) {
+                seenGeneration = bulkGeneration_;
+                if (bulkCount_ > 0) {
+                    bulkActive_++;
+                    lock.unlock();
+                    runBulkItems();
+                    lock.lock();
+                    if (--bulkActive_ == 0) {
+                        bulkDoneCv_.notify_one();
+                    }
+                }
+                continue;
+            }
+
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
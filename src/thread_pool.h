@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+// Fixed set of worker threads running queued jobs. Jobs still queued when
+// the pool is destroyed are dropped; running jobs are waited for.
+class ThreadPool {
+public:
+    // threads = 0: one per core, minus the main thread. Each worker runs
+    // onStart first, e.g. to set its own CPUs and priority; otherwise it
+    // keeps the creating thread's.
+    explicit ThreadPool(int threads = 0, std::function<void()> onStart = nullptr);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> job);
+    int getThreadCount() const { return static_cast<int>(workers_.size()); }
+
+    // Run fn(i) for every i in [0, count) on the calling thread and any idle
+    // workers, returning once all are done. Workers busy with queued jobs
+    // simply don't join in. No allocation, so it's safe on per-frame paths.
+    template <typename Fn>
+    void parallelFor(int count, Fn&& fn) {
+        using Body = std::remove_reference_t<Fn>;
+        runBulk(count, [](void* ctx, int i) { (*static_cast<Body*>(ctx))(i); }, &fn);
+    }
+
+    // Process-wide pool for per-frame work, placed like its first caller
+    static ThreadPool& shared();
+
+private:
+    void workerLoop(const std::function<void()>& onStart);
+    void runBulk(int count, void (*fn)(void*, int), void* ctx);
+    void runBulkItems();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+
+    // Current parallelFor; one at a time
+    std::mutex bulkMutex_;
+    std::condition_variable bulkDoneCv_;
+    void (*bulkFn_)(void*, int) = nullptr;
+    void* bulkCtx_ = nullptr;
+    int bulkCount_ = 0;
+    std::atomic<int> bulkNext_{0};
+    int bulkActive_ = 0;                // Workers inside runBulkItems (guarded by mutex_)
+    uint64_t bulkGeneration_ = 0;       // Bumped per parallelFor to wake workers (guarded by mutex_)
+};
@@ -0,0 +1,300 @@
+#include "v4l2_capture.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/videodev2.h>
+
+// Below this YUYV is not worth it; MJPEG (if available) keeps motion smooth
+static constexpr double MIN_YUYV_FPS = 24.0;
+
+// Retry ioctls interrupted by signals
+static int xioctl(int fd, unsigned long request, void* arg) {
+    int r;
+    do {
+        r = ioctl(fd, request, arg);
+    } while (r < 0 && errno == EINTR);
+    return r;
+}
+
+V4L2Capture::~V4L2Capture() {
+    close();
+}
+
+std::string V4L2Capture::fourccToString(uint32_t fourcc) {
+    std::string s(4, ' ');
+    for (int i = 0; i < 4; ++i) {
+        s[i] = static_cast<char>((fourcc >> (8 * i)) & 0xFF);
+    }
+    return s;
+}
+
+double V4L2Capture::maxFrameRate(uint32_t pixelFormat, int width, int height) const {
+    struct v4l2_frmivalenum ival{};
+    ival.pixel_format = pixelFormat;
+    ival.width = width;
+    ival.height = height;
+
+    double best = 0.0;
+    while (xioctl(fd_, VIDIOC_ENUM_FRAMEINTERVALS, &ival) == 0) {
+        const struct v4l2_fract& f = (ival.type == V4L2_FRMIVAL_TYPE_DISCRETE)
+            ? ival.discrete : ival.stepwise.min;
+        if (f.numerator > 0) {
+            best = std::max(best, static_cast<double>(f.denominator) / f.numerator);
+        }
+        if (ival.type != V4L2_FRMIVAL_TYPE_DISCRETE) break;
+        ival.index++;
+    }
+    return best;
+}
+
+uint32_t V4L2Capture::choosePixelFormat(int width, int height) const {
+    bool hasYUYV = false;
+    bool hasMJPEG = false;
+
+    struct v4l2_fmtdesc fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    while (xioctl(fd_, VIDIOC_ENUM_FMT, &fmt) == 0) {
+        if (fmt.pixelformat == V4L2_PIX_FMT_YUYV) hasYUYV = true;
+        if (fmt.pixelformat == V4L2_PIX_FMT_MJPEG) hasMJPEG = true;
+        fmt.index++;
+    }
+
+    // Raw YUYV can be forwarded untouched, but many cameras only manage a few
+    // FPS with it at high resolutions
+    if (hasYUYV && (!hasMJPEG || maxFrameRate(V4L2_PIX_FMT_YUYV, width, height) >= MIN_YUYV_FPS)) {
+        return V4L2_PIX_FMT_YUYV;
+    }
+    if (hasMJPEG) {
+        return V4L2_PIX_FMT_MJPEG;
+    }
+    return 0;  // Let the driver keep its current format
+}
+
+bool V4L2Capture::open(const std::string& device, int width, int height, int bufferCount) {
+    close();
+    device_ = device;
+
+    fd_ = ::open(device.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd_ < 0) {
+        std::cerr << "Failed to open " << device << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct v4l2_capability cap{};
+    if (xioctl(fd_, VIDIOC_QUERYCAP, &cap) < 0) {
+        std::cerr << "VIDIOC_QUERYCAP failed on " << device << ": " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+        std::cerr << device << " is not a streaming capture device" << std::endl;
+        close();
+        return false;
+    }
+
+    struct v4l2_format fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd_, VIDIOC_G_FMT, &fmt) < 0) {
+        std::cerr << "Failed to get capture format: " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    uint32_t pixelFormat = choosePixelFormat(width, height);
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    if (pixelFormat != 0) {
+        fmt.fmt.pix.pixelformat = pixelFormat;
+    }
+    fmt.fmt.pix.field = V4L2_FIELD_ANY;
+
+    if (xioctl(fd_, VIDIOC_S_FMT, &fmt) < 0) {
+        std::cerr << "Failed to set capture format: " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    width_ = fmt.fmt.pix.width;
+    height_ = fmt.fmt.pix.height;
+    bytesPerLine_ = fmt.fmt.pix.bytesperline;
+    pixelFormat_ = fmt.fmt.pix.pixelformat;
+
+    // Frame rate the driver settled on
+    struct v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fps_ = 30.0;
+    if (xioctl(fd_, VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator > 0) {
+        fps_ = static_cast<double>(parm.parm.capture.timeperframe.denominator) /
+               parm.parm.capture.timeperframe.numerator;
+    }
+
+    if (!initBuffers(bufferCount)) {
+        close();
+        return false;
+    }
+
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd_, VIDIOC_STREAMON, &type) < 0) {
+        std::cerr << "Failed to start capture stream: " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    streaming_ = true;
+
+    std::cout << "V4L2 capture: " << width_ << "x" << height_ << " " << fourccToString(pixelFormat_)
+              << ", " << buffers_.size() << " buffers" << std::endl;
+    return true;
+}
+
+bool V4L2Capture::initBuffers(int bufferCount) {
+    struct v4l2_requestbuffers req{};
+    req.count = std::max(bufferCount, 2);
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+
+    if (xioctl(fd_, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        std::cerr << "Failed to allocate capture buffers: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    for (unsigned int i = 0; i < req.count; ++i) {
+        struct v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+
+        if (xioctl(fd_, VIDIOC_QUERYBUF, &buf) < 0) {
+            std::cerr << "Failed to query capture buffer " << i << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        void* start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, buf.m.offset);
+        if (start == MAP_FAILED) {
+            std::cerr << "Failed to map capture buffer " << i << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        buffers_.push_back({start, buf.length});
+
+        if (xioctl(fd_, VIDIOC_QBUF, &buf) < 0) {
+            std::cerr << "Failed to queue capture buffer " << i << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void V4L2Capture::requeueHeld() {
+    if (held_ < 0) return;
+
+    struct v4l2_buffer buf{};
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = held_;
+    if (xioctl(fd_, VIDIOC_QBUF, &buf) < 0) {
+        std::cerr << "Failed to requeue capture buffer: " << strerror(errno) << std::endl;
+    }
+    held_ = -1;
+}
+
+bool V4L2Capture::dequeue(RawFrame& frame, int timeoutMs) {
+    if (fd_ < 0) return false;
+
+    requeueHeld();
+
+    while (true) {
+        struct pollfd pfd{fd_, POLLIN, 0};
+        int r = poll(&pfd, 1, timeoutMs);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            if (r == 0) std::cerr << "Capture timeout on " << device_ << std::endl;
+            return false;
+        }
+        if (pfd.revents & (POLLERR | POLLHUP)) {
+            return false;  // Device gone
+        }
+
+        struct v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(fd_, VIDIOC_DQBUF, &buf) < 0) {
+            if (errno == EAGAIN) continue;
+            std::cerr << "VIDIOC_DQBUF failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        // Corrupt frames go straight back to the driver
+        if ((buf.flags & V4L2_BUF_FLAG_ERROR) || buf.bytesused == 0) {
+            held_ = static_cast<int>(buf.index);
+            requeueHeld();
+            continue;
+        }
+
+        held_ = static_cast<int>(buf.index);
+        frame.data = static_cast<const uint8_t*>(buffers_[buf.index].start);
+        frame.size = buf.bytesused;
+        frame.pixelFormat = pixelFormat_;
+        frame.width = width_;
+        frame.height = height_;
+        frame.bytesPerLine = bytesPerLine_;
+        frame.timestampUs = static_cast<uint64_t>(buf.timestamp.tv_sec) * 1000000 + buf.timestamp.tv_usec;
+        return true;
+    }
+}
+
+int V4L2Capture::flush() {
+    if (fd_ < 0) return 0;
+
+    requeueHeld();
+    int flushed = 0;
+    // Bounded: a camera can refill buffers about as fast as they're returned
+    while (flushed < static_cast<int>(buffers_.size())) {
+        struct pollfd pfd{fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 0) <= 0 || (pfd.revents & (POLLERR | POLLHUP))) {
+            break;
+        }
+
+        struct v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(fd_, VIDIOC_DQBUF, &buf) < 0) {
+            break;
+        }
+        held_ = static_cast<int>(buf.index);
+        requeueHeld();
+        flushed++;
+    }
+    return flushed;
+}
+
+void V4L2Capture::close() {
+    if (fd_ >= 0 && streaming_) {
+        int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(fd_, VIDIOC_STREAMOFF, &type);
+    }
+    streaming_ = false;
+    held_ = -1;
+
+    for (auto& b : buffers_) {
+        munmap(b.start, b.length);
+    }
+    if (fd_ >= 0 && !buffers_.empty()) {
+        struct v4l2_requestbuffers req{};
+        req.count = 0;
+        req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        req.memory = V4L2_MEMORY_MMAP;
+        xioctl(fd_, VIDIOC_REQBUFS, &req);
+    }
+    buffers_.clear();
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
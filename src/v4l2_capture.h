@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// A captured frame still sitting in a driver buffer (no copy, no decode).
+// Valid until the next dequeue() or close().
+struct RawFrame {
+    const uint8_t* data = nullptr;
+    size_t size = 0;            // Bytes used in the buffer
+    uint32_t pixelFormat = 0;   // V4L2 fourcc (V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_MJPEG, ...)
+    int width = 0;
+    int height = 0;
+    size_t bytesPerLine = 0;    // 0 for compressed formats
+    uint64_t timestampUs = 0;   // Driver timestamp
+};
+
+// Native V4L2 capture: mmap buffer ring, STREAMON, DQBUF with poll timeouts
+class V4L2Capture {
+public:
+    V4L2Capture() = default;
+    ~V4L2Capture();
+
+    V4L2Capture(const V4L2Capture&) = delete;
+    V4L2Capture& operator=(const V4L2Capture&) = delete;
+
+    // Open at the given size; YUYV is preferred when the camera can deliver a
+    // usable frame rate with it, otherwise MJPEG. bufferCount trades latency
+    // (fewer) against tolerance to slow frames (more).
+    bool open(const std::string& device, int width, int height, int bufferCount = 3);
+
+    // Wait up to timeoutMs for the next frame. The previously returned frame
+    // is handed back to the driver first.
+    bool dequeue(RawFrame& frame, int timeoutMs);
+
+    // Hand frames that queued up while nobody was reading straight back to
+    // the driver, so the next dequeue() is fresh. Returns how many.
+    int flush();
+
+    bool isOpened() const { return fd_ >= 0; }
+    void close();
+
+    int getFd() const { return fd_; }
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    uint32_t getPixelFormat() const { return pixelFormat_; }
+    double getFPS() const { return fps_; }
+    int getBufferCount() const { return static_cast<int>(buffers_.size()); }
+
+    static std::string fourccToString(uint32_t fourcc);
+
+private:
+    struct MappedBuffer {
+        void* start = nullptr;
+        size_t length = 0;
+    };
+
+    uint32_t choosePixelFormat(int width, int height) const;
+    double maxFrameRate(uint32_t pixelFormat, int width, int height) const;
+    bool initBuffers(int bufferCount);
+    void requeueHeld();
+
+    int fd_ = -1;
+    int width_ = 0;
+    int height_ = 0;
+    size_t bytesPerLine_ = 0;
+    uint32_t pixelFormat_ = 0;
+    double fps_ = 30.0;
+    std::string device_;
+
+    std::vector<MappedBuffer> buffers_;
+    int held_ = -1;                 // Buffer index currently lent out via dequeue()
+    bool streaming_ = false;
+};
@@ -1,17 +1,32 @@
 #include "virtual_output.h"
+#include "stage_stats.h"
 #include <iostream>
 #include <filesystem>
+#include <algorithm>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <linux/videodev2.h>
 #include <cstring>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+// Result of a write() of one frame
+void VirtualOutput::countWrite(bool ok) const {
+    if (!ok) {
+        std::cerr << "Write error: " << strerror(errno) << std::endl;
+        StageStats::instance().add(Counter::WRITE_ERRORS);
+    } else if (countFrames_) {
+        StageStats::instance().add(Counter::FRAMES);
+    }
+}
 
 VirtualOutput::~VirtualOutput() {
     close();
 }
 
-bool VirtualOutput::open(const std::string& device, int width, int height, double /*fps*/) {
+bool VirtualOutput::open(const std::string& device, int width, int height, double /*fps*/, int bufferCount) {
     close();
 
     device_ = device;
@@ -53,6 +68,8 @@ bool VirtualOutput::open(const std::string& device, int width, int height, doubl
     height_ = fmt.fmt.pix.height;
     bytesPerLine_ = fmt.fmt.pix.bytesperline;
     frameSize_ = fmt.fmt.pix.sizeimage;
+    if (bytesPerLine_ < static_cast<size_t>(width_) * 2) bytesPerLine_ = width_ * 2;
+    if (frameSize_ < bytesPerLine_ * height_) frameSize_ = bytesPerLine_ * height_;
 
     // Verify format was accepted
     if (width_ != width || height_ != height) {
@@ -60,38 +77,220 @@ bool VirtualOutput::open(const std::string& device, int width, int height, doubl
                   << " (requested " << width << "x" << height << ")" << std::endl;
     }
 
-    std::cout << "Opened virtual camera: " << device << " (" << width_ << "x" << height_ << " YUYV)" << std::endl;
+    // Prefer streaming into mapped driver buffers; write() if the driver refuses
+    ioMode_ = IoMode::WRITE;
+    if (bufferCount > 0 && initStreaming(bufferCount)) {
+        ioMode_ = IoMode::MMAP;
+    } else {
+        // Allocate the output frame once; every write reuses it
+        storage_.assign(frameSize_, 0);
+        buffer_ = cv::Mat(height_, width_, CV_8UC2, storage_.data(), bytesPerLine_);
+    }
+
+    std::cout << "Opened virtual camera: " << device << " (" << width_ << "x" << height_ << " YUYV, ";
+    if (ioMode_ == IoMode::MMAP) {
+        std::cout << "mmap streaming x" << mapped_.size() << ")" << std::endl;
+    } else {
+        std::cout << "write())" << std::endl;
+    }
     return true;
 }
 
+bool VirtualOutput::initStreaming(int bufferCount) {
+    struct v4l2_requestbuffers req{};
+    req.count = std::clamp(bufferCount, 2, 8);
+    req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    req.memory = V4L2_MEMORY_MMAP;
+
+    if (ioctl(fd_, VIDIOC_REQBUFS, &req) < 0) {
+        std::cout << "Note: " << device_ << " doesn't support mmap streaming, using write()" << std::endl;
+        return false;
+    }
+    buffersRequested_ = true;
+    if (req.count < 2) {
+        std::cout << "Note: " << device_ << " only granted " << req.count << " buffer(s), using write()" << std::endl;
+        stopStreaming();
+        return false;
+    }
+
+    for (unsigned int i = 0; i < req.count; ++i) {
+        struct v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+
+        if (ioctl(fd_, VIDIOC_QUERYBUF, &buf) < 0 || buf.length < frameSize_) {
+            std::cerr << "Failed to query output buffer " << i << ": " << strerror(errno) << std::endl;
+            stopStreaming();
+            return false;
+        }
+
+        void* start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, buf.m.offset);
+        if (start == MAP_FAILED) {
+            std::cerr << "Failed to map output buffer " << i << ": " << strerror(errno) << std::endl;
+            stopStreaming();
+            return false;
+        }
+        mapped_.push_back({start, buf.length});
+    }
+
+    nextFresh_ = 0;
+    current_ = -1;
+    streaming_ = false;
+    return true;
+}
+
+void VirtualOutput::stopStreaming() {
+    if (fd_ >= 0 && streaming_) {
+        int type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+        ioctl(fd_, VIDIOC_STREAMOFF, &type);
+    }
+    streaming_ = false;
+
+    for (auto& m : mapped_) {
+        munmap(m.start, m.length);
+    }
+    mapped_.clear();
+
+    if (fd_ >= 0 && buffersRequested_) {
+        // Release the driver's buffers
+        struct v4l2_requestbuffers req{};
+        req.count = 0;
+        req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+        req.memory = V4L2_MEMORY_MMAP;
+        ioctl(fd_, VIDIOC_REQBUFS, &req);
+    }
+    buffersRequested_ = false;
+    nextFresh_ = 0;
+    current_ = -1;
+}
+
+void VirtualOutput::fallBackToWrite(const char* reason) {
+    std::cerr << "Warning: mmap streaming failed (" << reason << ": " << strerror(errno)
+              << "), falling back to write()" << std::endl;
+    stopStreaming();
+    ioMode_ = IoMode::WRITE;
+    storage_.assign(frameSize_, 0);
+    buffer_ = cv::Mat(height_, width_, CV_8UC2, storage_.data(), bytesPerLine_);
+}
+
+int VirtualOutput::dequeueBuffer() {
+    // Don't block the frame loop forever if the driver stops returning buffers
+    struct pollfd pfd{fd_, POLLOUT, 0};
+    if (poll(&pfd, 1, 1000) <= 0) {
+        return -1;
+    }
+
+    struct v4l2_buffer buf{};
+    buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (ioctl(fd_, VIDIOC_DQBUF, &buf) < 0) {
+        return -1;
+    }
+    return static_cast<int>(buf.index);
+}
+
 void VirtualOutput::writeFrame(const cv::Mat& frame) {
     if (fd_ < 0 || frame.empty()) {
         return;
     }
 
-    cv::Mat resized;
-    if (frame.cols != width_ || frame.rows != height_) {
-        cv::resize(frame, resized, cv::Size(width_, height_));
+    {
+        StageTimer timer(Stage::CONVERT);
+        // Scale and convert BGR to YUYV straight into the output buffer
+        scaler_.toYUYV(frame, acquireBuffer());
+    }
+    commitBuffer();
+}
+
+void VirtualOutput::writeFrameYUYV(const cv::Mat& yuyv) {
+    if (fd_ < 0 || yuyv.empty()) {
+        return;
+    }
+
+    if (yuyv.cols != width_ || yuyv.rows != height_ || yuyv.type() != CV_8UC2) {
+        std::cerr << "Warning: YUYV frame " << yuyv.cols << "x" << yuyv.rows
+                  << " doesn't match output " << width_ << "x" << height_ << std::endl;
+        return;
+    }
+
+    // A tightly packed frame can be written as-is without staging it first
+    if (ioMode_ == IoMode::WRITE && yuyv.isContinuous() && frameSize_ == yuyv.total() * 2) {
+        StageTimer timer(Stage::WRITE);
+        ssize_t written = write(fd_, yuyv.data, frameSize_);
+        countWrite(written >= 0);
+        return;
+    }
+
+    cv::Mat& dst = acquireBuffer();
+    if (yuyv.data != dst.data) {
+        yuyv.copyTo(dst);
+    }
+    commitBuffer();
+}
+
+cv::Mat& VirtualOutput::acquireBuffer() {
+    if (ioMode_ != IoMode::MMAP || current_ >= 0) {
+        return buffer_;
+    }
+
+    int index;
+    if (nextFresh_ < static_cast<int>(mapped_.size())) {
+        index = nextFresh_++;
     } else {
-        resized = frame;
+        index = dequeueBuffer();
+        if (index < 0) {
+            fallBackToWrite("dequeue");
+            return buffer_;
+        }
+    }
+
+    current_ = index;
+    buffer_ = cv::Mat(height_, width_, CV_8UC2, mapped_[index].start, bytesPerLine_);
+    return buffer_;
+}
+
+void VirtualOutput::commitBuffer() {
+    if (fd_ < 0) {
+        return;
+    }
+
+    StageTimer timer(Stage::WRITE);
+    if (ioMode_ == IoMode::WRITE) {
+        ssize_t written = write(fd_, storage_.data(), frameSize_);
+        countWrite(written >= 0);
+        return;
     }
 
-    // Convert BGR to YUYV
-    cv::Mat yuyv;
-    cv::cvtColor(resized, yuyv, cv::COLOR_BGR2YUV_YUYV);
+    if (current_ < 0) {
+        return;  // Nothing acquired
+    }
 
-    // Write exactly the buffer size (not the pre-computed frameSize_)
-    size_t bytesToWrite = yuyv.total() * yuyv.elemSize();
+    struct v4l2_buffer buf{};
+    buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = current_;
+    buf.bytesused = frameSize_;
+    buf.field = V4L2_FIELD_NONE;
+    gettimeofday(&buf.timestamp, nullptr);
+    current_ = -1;
 
-    // Sanity check: warn if sizes don't match
-    if (bytesToWrite != frameSize_) {
-        std::cerr << "Warning: Buffer size mismatch (buffer=" << bytesToWrite
-                  << ", expected=" << frameSize_ << ")" << std::endl;
+    if (ioctl(fd_, VIDIOC_QBUF, &buf) < 0) {
+        StageStats::instance().add(Counter::WRITE_ERRORS);
+        fallBackToWrite("queue");
+        return;
+    }
+    if (countFrames_) {
+        StageStats::instance().add(Counter::FRAMES);
     }
 
-    ssize_t written = write(fd_, yuyv.data, bytesToWrite);
-    if (written < 0) {
-        std::cerr << "Write error: " << strerror(errno) << std::endl;
+    if (!streaming_) {
+        int type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+        if (ioctl(fd_, VIDIOC_STREAMON, &type) < 0) {
+            fallBackToWrite("stream on");
+            return;
+        }
+        streaming_ = true;
     }
 }
 
@@ -100,8 +299,12 @@ bool VirtualOutput::isOpened() const {
 }
 
 void VirtualOutput::close() {
+    stopStreaming();
     if (fd_ >= 0) {
         ::close(fd_);
         fd_ = -1;
     }
+    buffer_.release();
+    storage_.clear();
+    ioMode_ = IoMode::WRITE;
 }
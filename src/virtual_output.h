@@ -2,26 +2,70 @@
 
 #include <opencv2/opencv.hpp>
 #include <string>
+#include <vector>
+#include "frame_sink.h"
 
-class VirtualOutput {
+class VirtualOutput : public FrameSink {
 public:
+    // How frames reach the driver
+    enum class IoMode {
+        WRITE,      // write() syscall, frame copied into the kernel
+        MMAP        // V4L2 streaming into driver buffers mapped into our process
+    };
+
     VirtualOutput() = default;
-    ~VirtualOutput();
+    ~VirtualOutput() override;
+
+    // bufferCount: size of the mmap ring (0 = always use write())
+    bool open(const std::string& device, int width, int height, double fps, int bufferCount = 3);
+    void writeFrame(const cv::Mat& frame) override;
+    void writeFrameYUYV(const cv::Mat& yuyv) override;
 
-    bool open(const std::string& device, int width, int height, double fps);
-    void writeFrame(const cv::Mat& frame);
+    // YUYV (CV_8UC2) frame at the negotiated size. Render into it, then
+    // commitBuffer() to send it; no per-frame allocation or conversion.
+    // In MMAP mode this is a driver buffer, so its previous contents are stale.
+    cv::Mat& acquireBuffer() override;
+    void commitBuffer() override;
     bool isOpened() const;
     void close();
 
     // Get the actual negotiated resolution (may differ from requested)
-    int getWidth() const { return width_; }
-    int getHeight() const { return height_; }
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+    IoMode getIoMode() const { return ioMode_; }
+
+    // Off when a fan-out counts each frame once for all of its outputs
+    void setCountFrames(bool count) { countFrames_ = count; }
 
 private:
+    struct MappedBuffer {
+        void* start = nullptr;
+        size_t length = 0;
+    };
+
+    bool initStreaming(int bufferCount);
+    void stopStreaming();
+    void fallBackToWrite(const char* reason);
+    int dequeueBuffer();
+
+    void countWrite(bool ok) const;
+
     int fd_ = -1;
+    bool countFrames_ = true;
     int width_ = 0;
     int height_ = 0;
     size_t bytesPerLine_ = 0;
     size_t frameSize_ = 0;
     std::string device_;
+    IoMode ioMode_ = IoMode::WRITE;
+
+    std::vector<uint8_t> storage_;   // WRITE mode: frameSize_ bytes, exactly what write() sends
+    cv::Mat buffer_;                 // YUYV view over storage_ or the acquired driver buffer
+
+    // MMAP mode ring
+    std::vector<MappedBuffer> mapped_;
+    int nextFresh_ = 0;              // Buffers never queued yet are handed out first
+    int current_ = -1;               // Index of the acquired buffer
+    bool buffersRequested_ = false;  // REQBUFS succeeded, must be released
+    bool streaming_ = false;         // STREAMON issued
 };